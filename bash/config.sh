@@ -20,6 +20,7 @@ fitter_ROOT="off"
 fitter_Ceres="off"
 
 cmd="off"
+bench="off"
 gui="off"
 
 DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )/../src" && pwd )/config"
@@ -35,6 +36,9 @@ else
   if grep -q QPX_CMD ${FILE}; then
     cmd="on"
   fi
+  if grep -q QPX_BENCH ${FILE}; then
+    bench="on"
+  fi
   if grep -q QPX_GUI ${FILE}; then
     gui="on"
   fi
@@ -74,11 +78,12 @@ else
   fi
 fi
 
-cmd1=(--title Options --checklist "Base program options:" 10 60 16)
+cmd1=(--title Options --checklist "Base program options:" 11 60 16)
 options1=(
          1 "QPX Graphical Interface" "$gui"
          2 "Command line tool" "$cmd"
          3 "Use HDF5 (experimental)" "$hdf5"
+         13 "Pipeline benchmarks (qpx_bench)" "$bench"
         )
 
 cmd2=(--and-widget --title Producers --checklist "Build the following data producer plugins:" 14 60 16)
@@ -161,6 +166,9 @@ do
         12)
             text+=$'set(QPX_FITTER_CERES TRUE PARENT_SCOPE)\n'
             ;;
+        13)
+            text+=$'set(QPX_BENCH TRUE PARENT_SCOPE)\n'
+            ;;
     esac
 done
 
@@ -0,0 +1,423 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      qpx_bench  synthetic pipeline benchmarks with JSON output, so that
+ *                 results from different builds can be diffed:
+ *                 spill queue, presort, event building, 1D and 2D fills,
+ *                 project save and load. Each case runs without and
+ *                 with traces.
+ *
+ *      Usage: qpx_bench [channels=4] [rate=20000] [coinc=0.3] [window=200]
+ *                       [seconds=2] [spill=0.1] [devices=2] [trace=256]
+ *                       [seed=1] [out=file.json] [verbose=0]
+ *
+ ******************************************************************************/
+
+#include "synthetic_stream.h"
+#include "engine.h"
+#include "event_builder.h"
+#include "consumer_factory.h"
+#include "pipeline_metrics.h"
+#include "custom_logger.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
+#include <boost/log/core.hpp>
+#include <fstream>
+#include <iostream>
+
+namespace Qpx {
+
+struct BenchResult
+{
+  std::string name;
+  uint64_t hits {0};
+  double   seconds {0};
+  double   p50_us {0};
+  double   p99_us {0};
+  double   max_us {0};
+  json     extra;
+};
+
+void to_json(json& j, const BenchResult &r)
+{
+  j["name"]    = r.name;
+  j["hits"]    = r.hits;
+  j["seconds"] = r.seconds;
+  j["hits_per_s"] = (r.seconds > 0) ? (r.hits / r.seconds) : 0.0;
+  j["p50_us"]  = r.p50_us;
+  j["p99_us"]  = r.p99_us;
+  j["max_us"]  = r.max_us;
+  if (!r.extra.is_null())
+    j["extra"] = r.extra;
+}
+
+class PipelineBench
+{
+public:
+  explicit PipelineBench(const StreamConfig& config)
+    : stream_(config)
+  {}
+
+  json run()
+  {
+    std::string suffix = stream_.config().trace_length ? " traces" : "";
+    json ret;
+    ret["config"] = stream_.config();
+    ret["config"]["hits"] = stream_.hits();
+    ret["results"].push_back(bench_queue(suffix));
+    ret["results"].push_back(bench_presort(suffix));
+    ret["results"].push_back(bench_build(suffix));
+    ret["results"].push_back(bench_fill("1D", 1, suffix));
+    ret["results"].push_back(bench_fill("2D", 2, suffix));
+    for (auto &r : bench_save_load(suffix))
+      ret["results"].push_back(r);
+    return ret;
+  }
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  SyntheticStream stream_;
+  std::vector<SinkPtr> filled_;
+
+  static uint64_t ns_since(Clock::time_point start)
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+  }
+
+  static uint64_t count_hits(const std::vector<Spill>& spills)
+  {
+    uint64_t ret = 0;
+    for (auto &s : spills)
+      ret += s.hits.size();
+    return ret;
+  }
+
+  static void percentiles(BenchResult& r, const LatencyHistogram& h)
+  {
+    r.p50_us = h.percentile(0.50) * 0.001;
+    r.p99_us = h.percentile(0.99) * 0.001;
+    r.max_us = h.max() * 0.001;
+  }
+
+  //enqueue to dequeue latency; copies are made on the producer side,
+  //as a producer would allocate its spills
+  BenchResult bench_queue(const std::string& suffix)
+  {
+    BenchResult ret;
+    ret.name = "queue" + suffix;
+    std::vector<Spill> spills = stream_.device_spills();
+    ret.hits = count_hits(spills);
+
+    BoundedSpillQueue queue(64);
+    std::vector<Clock::time_point> stamps(spills.size());
+    LatencyHistogram latency;
+
+    auto start = Clock::now();
+    boost::thread producer([&]() {
+      for (size_t i = 0; i < spills.size(); ++i)
+      {
+        std::unique_ptr<Spill> s(new Spill(spills[i]));
+        stamps[i] = Clock::now();
+        queue.enqueue(std::move(s));
+      }
+    });
+
+    for (size_t i = 0; i < spills.size(); ++i)
+    {
+      std::unique_ptr<Spill> s = queue.dequeue();
+      if (!s)
+        break;
+      latency.record(ns_since(stamps[i]));
+    }
+    ret.seconds = ns_since(start) * 1.0e-9;
+    producer.join();
+    queue.stop();
+
+    percentiles(ret, latency);
+    ret.extra["queue"] = queue.stats().to_string();
+    return ret;
+  }
+
+  //worker_MCA merging device spills into an empty project
+  BenchResult bench_presort(const std::string& suffix)
+  {
+    BenchResult ret;
+    ret.name = "presort" + suffix;
+    std::vector<Spill> spills = stream_.device_spills();
+    ret.hits = count_hits(spills);
+
+    ProjectPtr project = std::make_shared<Project>();
+    BoundedSpillQueue queue(1024);
+    PipelineMetrics::get().reset();
+
+    auto start = Clock::now();
+    boost::thread builder(boost::bind(&Engine::worker_MCA, &Engine::getInstance(),
+                                      &queue, project));
+    for (auto &s : spills)
+      queue.enqueue(std::unique_ptr<Spill>(new Spill(s)));
+    while (queue.size() > 0)
+      boost::this_thread::sleep_for(boost::chrono::milliseconds(1));
+    queue.stop();
+    builder.join();
+    ret.seconds = ns_since(start) * 1.0e-9;
+
+    for (auto &st : PipelineMetrics::get().snapshot().stages)
+      if (st.name == Stage::presort)
+      {
+        ret.p50_us = st.p50_us;
+        ret.p99_us = st.p99_us;
+        ret.max_us = st.max_us;
+        ret.extra["presort_busy_s"] = st.busy_s;
+      }
+    return ret;
+  }
+
+  //coincidence building alone, all channels relevant
+  BenchResult bench_build(const std::string& suffix)
+  {
+    BenchResult ret;
+    ret.name = "build" + suffix;
+    std::vector<Spill> spills = stream_.sorted_spills();
+    ret.hits = count_hits(spills);
+
+    size_t chans = stream_.config().channels;
+    CoincidenceSetup setup;
+    setup.coinc_window = stream_.config().coinc_window_ns;
+    setup.bits = 16;
+    setup.delay_ns.resize(chans, 0);
+    setup.cutoff_logic.resize(chans, 0);
+    setup.relevant.resize(chans, true);
+    EventBuilder builder(setup);
+
+    LatencyHistogram latency;
+    uint64_t events = 0;
+    EventBatch finished;
+    auto start = Clock::now();
+    for (auto &s : spills)
+    {
+      auto t = Clock::now();
+      finished.clear();
+      builder.push_spill(s, finished);
+      events += finished.size();
+      latency.record(ns_since(t));
+    }
+    ret.seconds = ns_since(start) * 1.0e-9;
+
+    percentiles(ret, latency);
+    ret.extra["events"] = events;
+    BuildCounts counts = builder.diagnostics().counts();
+    ret.extra["multiple"] = counts.multiple;
+    ret.extra["pileup"] = counts.pileup;
+    return ret;
+  }
+
+  SinkPtr make_sink(std::string type, size_t dimensions)
+  {
+    size_t chans = stream_.config().channels;
+    ConsumerMetadata md = ConsumerFactory::getInstance().create_prototype(type);
+
+    Setting name = md.get_attribute("name");
+    name.value_text = "bench " + type;
+    md.set_attribute(name);
+
+    Setting res = md.get_attribute("resolution");
+    res.value_int = (dimensions > 1) ? 12 : 14;
+    md.set_attribute(res);
+
+    Setting window = md.get_attribute("coinc_window");
+    window.value_dbl = stream_.config().coinc_window_ns;
+    md.set_attribute(window);
+
+    //1D: any channel; 2D: the first two in coincidence
+    std::vector<bool> gates(chans, dimensions == 1);
+    for (size_t i = 0; (i < dimensions) && (i < chans); ++i)
+      gates[i] = true;
+    for (auto id : {"pattern_coinc", "pattern_add"})
+    {
+      Setting pattern = md.get_attribute(id);
+      pattern.value_pattern.resize(chans);
+      pattern.value_pattern.set_gates(gates);
+      pattern.value_pattern.set_theshold(dimensions);
+      md.set_attribute(pattern);
+    }
+
+    SinkPtr ret = ConsumerFactory::getInstance().create_from_prototype(md);
+    if (ret)
+    {
+      std::vector<Detector> dets;
+      for (size_t i = 0; i < chans; ++i)
+        dets.push_back(Detector("det" + std::to_string(i)));
+      ret->set_detectors(dets);
+    }
+    return ret;
+  }
+
+  BenchResult bench_fill(std::string type, size_t dimensions, const std::string& suffix)
+  {
+    BenchResult ret;
+    ret.name = "fill_" + type + suffix;
+    std::vector<Spill> spills = stream_.sorted_spills();
+    ret.hits = count_hits(spills);
+
+    SinkPtr sink = make_sink(type, dimensions);
+    if (!sink)
+    {
+      ret.extra["error"] = "could not create " + type;
+      return ret;
+    }
+
+    LatencyHistogram latency;
+    auto start = Clock::now();
+    for (auto &s : spills)
+    {
+      auto t = Clock::now();
+      sink->push_spill(s);
+      latency.record(ns_since(t));
+    }
+    sink->flush();
+    ret.seconds = ns_since(start) * 1.0e-9;
+
+    percentiles(ret, latency);
+    ret.extra["total_hits"] = static_cast<double>(sink->metadata().get_attribute("total_hits").value_precise);
+    filled_.push_back(sink);
+    return ret;
+  }
+
+  //round trip of the filled sinks through the project file format
+  std::vector<BenchResult> bench_save_load(const std::string& suffix)
+  {
+#ifdef H5_ENABLED
+    std::string format = "h5";
+#else
+    std::string format = "xml";
+#endif
+    namespace fs = boost::filesystem;
+    fs::path file = fs::temp_directory_path() / fs::unique_path("qpx_bench_%%%%%%%%." + format);
+
+    BenchResult save, load;
+    save.name = "save_" + format + suffix;
+    load.name = "load_" + format + suffix;
+
+    Project project;
+    for (auto &s : filled_)
+      project.add_sink(s);
+
+    auto start = Clock::now();
+    project.save_as(file.string());
+    save.seconds = ns_since(start) * 1.0e-9;
+
+    Project reloaded;
+    start = Clock::now();
+    reloaded.open(file.string());
+    load.seconds = ns_since(start) * 1.0e-9;
+
+    boost::system::error_code ec;
+    save.extra["bytes"] = static_cast<uint64_t>(fs::file_size(file, ec));
+    load.extra["sinks"] = reloaded.get_sinks().size();
+    fs::remove(file, ec);
+
+    filled_.clear();
+    return {save, load};
+  }
+};
+
+}
+
+using namespace Qpx;
+
+int main(int argc, char *argv[])
+{
+  StreamConfig config;
+  size_t trace_length = 256;
+  std::string out;
+  bool verbose = false;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg(argv[i]);
+    size_t eq = arg.find('=');
+    if (eq == std::string::npos)
+    {
+      std::cerr << "Usage: qpx_bench [key=value ...]\n"
+                << "  channels rate coinc window seconds spill devices trace seed out verbose\n";
+      return 1;
+    }
+    std::string key = arg.substr(0, eq);
+    std::string val = arg.substr(eq + 1);
+    try
+    {
+      if (key == "channels")
+        config.channels = std::stoi(val);
+      else if (key == "rate")
+        config.rate_cps = std::stod(val);
+      else if (key == "coinc")
+        config.coinc_fraction = std::stod(val);
+      else if (key == "window")
+        config.coinc_window_ns = std::stod(val);
+      else if (key == "seconds")
+        config.duration_s = std::stod(val);
+      else if (key == "spill")
+        config.spill_s = std::stod(val);
+      else if (key == "devices")
+        config.devices = std::stoi(val);
+      else if (key == "trace")
+        trace_length = std::stoul(val);
+      else if (key == "seed")
+        config.seed = std::stoull(val);
+      else if (key == "out")
+        out = val;
+      else if (key == "verbose")
+        verbose = (std::stoi(val) != 0);
+      else
+      {
+        std::cerr << "Unknown parameter " << key << "\n";
+        return 1;
+      }
+    }
+    catch (...)
+    {
+      std::cerr << "Bad value for " << key << "\n";
+      return 1;
+    }
+  }
+
+  //engine chatter would swamp the timings
+  if (verbose)
+    CustomLogger::initLogger(nullptr, "qpx_bench_%N.log");
+  else
+    boost::log::core::get()->set_logging_enabled(false);
+
+  json result;
+  config.trace_length = 0;
+  result["runs"].push_back(PipelineBench(config).run());
+  if (trace_length)
+  {
+    config.trace_length = trace_length;
+    result["runs"].push_back(PipelineBench(config).run());
+  }
+
+  if (out.empty())
+    std::cout << result.dump(2) << std::endl;
+  else
+  {
+    std::ofstream file(out);
+    file << result.dump(2) << std::endl;
+  }
+
+  if (verbose)
+    CustomLogger::closeLogger();
+  return 0;
+}
@@ -0,0 +1,192 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::SyntheticStream  reproducible hit streams for benchmarking
+ *
+ ******************************************************************************/
+
+#include "synthetic_stream.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace Qpx {
+
+void to_json(json& j, const StreamConfig &s)
+{
+  j["channels"]        = s.channels;
+  j["devices"]         = s.devices;
+  j["rate_cps"]        = s.rate_cps;
+  j["coinc_fraction"]  = s.coinc_fraction;
+  j["coinc_window_ns"] = s.coinc_window_ns;
+  j["duration_s"]      = s.duration_s;
+  j["spill_s"]         = s.spill_s;
+  j["trace_length"]    = s.trace_length;
+  j["seed"]            = s.seed;
+}
+
+SyntheticStream::SyntheticStream(const StreamConfig& config)
+  : config_(config)
+{
+  if (config_.channels < 1)
+    config_.channels = 1;
+  if ((config_.devices < 1) || (config_.devices > config_.channels))
+    config_.devices = 1;
+
+  model_.timebase = TimeStamp(1, 1);  //ns ticks
+  model_.add_value("energy", 16);
+  model_.tracelength = config_.trace_length;
+
+  generate();
+}
+
+void SyntheticStream::generate()
+{
+  std::mt19937_64 gen(config_.seed);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  std::uniform_real_distribution<double> jitter(0.0, config_.coinc_window_ns * 0.5);
+  std::uniform_int_distribution<int> other(1, std::max(1, config_.channels - 1));
+  std::uniform_int_distribution<int> continuum(0, 65535);
+  std::normal_distribution<double> peak(0.0, 40.0);
+
+  //a few lines over a flat continuum, distinct per channel
+  auto energy = [&](int16_t chan) -> uint16_t {
+    if (unit(gen) < 0.3)
+      return continuum(gen);
+    double line = 4000.0 * (1 + (continuum(gen) % 4)) + 500.0 * chan;
+    return static_cast<uint16_t>(std::min(65535.0, std::max(0.0, line + peak(gen))));
+  };
+
+  uint64_t end = static_cast<uint64_t>(config_.duration_s * 1.0e9);
+  double mean_gap = 1.0e9 / std::max(config_.rate_cps, 1.0);
+  std::exponential_distribution<double> gap(1.0 / mean_gap);
+
+  hits_.clear();
+  hits_.reserve(static_cast<size_t>(config_.duration_s * config_.rate_cps * config_.channels
+                                    * (1.0 + config_.coinc_fraction) * 1.1));
+  for (int16_t chan = 0; chan < config_.channels; ++chan)
+  {
+    double t = gap(gen);
+    while (t < end)
+    {
+      uint64_t time = static_cast<uint64_t>(t);
+      hits_.push_back(RawHit{time, chan, energy(chan)});
+      if ((config_.channels > 1) && (unit(gen) < config_.coinc_fraction))
+      {
+        int16_t partner = (chan + other(gen)) % config_.channels;
+        hits_.push_back(RawHit{time + static_cast<uint64_t>(jitter(gen)),
+                               partner, energy(partner)});
+      }
+      t += gap(gen);
+    }
+  }
+
+  std::stable_sort(hits_.begin(), hits_.end(),
+                   [](const RawHit& a, const RawHit& b) { return a.time < b.time; });
+}
+
+Spill SyntheticStream::stats_spill(const std::vector<int16_t>& channels,
+                                   StatsUpdate::Type type,
+                                   boost::posix_time::ptime time) const
+{
+  Spill spill;
+  spill.time = time;
+  for (auto &c : channels)
+  {
+    StatsUpdate s;
+    s.stats_type = type;
+    s.source_channel = c;
+    s.model_hit = model_;
+    s.lab_time = time;
+    spill.stats[c] = s;
+  }
+  return spill;
+}
+
+std::vector<Spill> SyntheticStream::make_spills(const std::vector<std::vector<int16_t>>& groups) const
+{
+  //fixed wall clock origin, so that output is identical between runs
+  boost::posix_time::ptime origin(boost::gregorian::date(2000, 1, 1));
+  uint64_t spill_ns = static_cast<uint64_t>(std::max(config_.spill_s, 1.0e-6) * 1.0e9);
+  uint64_t end = static_cast<uint64_t>(config_.duration_s * 1.0e9);
+
+  std::vector<int16_t> group_of(config_.channels, 0);
+  for (size_t g = 0; g < groups.size(); ++g)
+    for (auto &c : groups[g])
+      group_of[c] = g;
+
+  std::vector<Spill> ret;
+  for (auto &g : groups)
+    ret.push_back(stats_spill(g, StatsUpdate::Type::start, origin));
+
+  std::vector<uint16_t> trace(config_.trace_length);
+  size_t next = 0;
+  for (uint64_t from = 0; from < end; from += spill_ns)
+  {
+    uint64_t to = from + spill_ns;
+    boost::posix_time::ptime lab = origin + boost::posix_time::microseconds(to / 1000);
+
+    std::vector<Spill> batch;
+    for (auto &g : groups)
+      batch.push_back(stats_spill(g, StatsUpdate::Type::running, lab));
+
+    std::vector<TraceArenaPtr> arenas(groups.size());
+    for (; (next < hits_.size()) && (hits_[next].time < to); ++next)
+    {
+      const RawHit& r = hits_[next];
+      size_t g = group_of[r.channel];
+      Hit h(r.channel, model_);
+      h.set_timestamp_native(r.time);
+      h.set_value(0, r.energy);
+      if (config_.trace_length)
+      {
+        if (!arenas[g])
+          arenas[g] = std::make_shared<TraceArena>();
+        //baseline and a decaying pulse scaled by energy
+        for (size_t i = 0; i < trace.size(); ++i)
+          trace[i] = 100 + ((i < trace.size() / 4) ? 0 :
+                            static_cast<uint16_t>((r.energy >> 4) * std::exp(-(i - trace.size() / 4.0) / 16.0)));
+        h.set_trace(trace.data(), trace.size(), arenas[g]);
+      }
+      batch[g].hits.push_back(h);
+    }
+
+    for (auto &b : batch)
+      ret.push_back(std::move(b));
+  }
+
+  boost::posix_time::ptime last = origin + boost::posix_time::microseconds(end / 1000);
+  for (auto &g : groups)
+    ret.push_back(stats_spill(g, StatsUpdate::Type::stop, last));
+
+  return ret;
+}
+
+std::vector<Spill> SyntheticStream::device_spills() const
+{
+  std::vector<std::vector<int16_t>> groups(config_.devices);
+  for (int16_t c = 0; c < config_.channels; ++c)
+    groups[c % config_.devices].push_back(c);
+  return make_spills(groups);
+}
+
+std::vector<Spill> SyntheticStream::sorted_spills() const
+{
+  std::vector<std::vector<int16_t>> groups(1);
+  for (int16_t c = 0; c < config_.channels; ++c)
+    groups[0].push_back(c);
+  return make_spills(groups);
+}
+
+}
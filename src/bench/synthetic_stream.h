@@ -0,0 +1,79 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::SyntheticStream  reproducible hit streams for benchmarking:
+ *                            Poisson arrivals per channel, a fraction of
+ *                            hits with a coincident partner, optional
+ *                            traces. Same seed, same stream.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "spill.h"
+#include "json.hpp"
+using namespace nlohmann;
+
+namespace Qpx {
+
+struct StreamConfig
+{
+  uint16_t channels {4};
+  uint16_t devices {2};           //channels dealt round-robin to devices
+  double   rate_cps {20000};      //primary hits per channel
+  double   coinc_fraction {0.3};  //primaries followed by a partner hit
+  double   coinc_window_ns {200};
+  double   duration_s {2};        //simulated time
+  double   spill_s {0.1};
+  size_t   trace_length {0};
+  uint64_t seed {1};
+};
+
+void to_json(json& j, const StreamConfig &s);
+
+class SyntheticStream
+{
+public:
+  explicit SyntheticStream(const StreamConfig& config);
+
+  const StreamConfig& config() const { return config_; }
+  const HitModel& model() const { return model_; }
+  uint64_t hits() const { return hits_.size(); }
+
+  //as devices would deliver them: per-device time order only,
+  //start stats first and stop stats last, one spill per device each
+  std::vector<Spill> device_spills() const;
+
+  //globally time-ordered, as the presorter delivers to sinks
+  std::vector<Spill> sorted_spills() const;
+
+private:
+  struct RawHit
+  {
+    uint64_t time;
+    int16_t  channel;
+    uint16_t energy;
+  };
+
+  StreamConfig config_;
+  HitModel model_;
+  std::vector<RawHit> hits_;  //time-ordered
+
+  void generate();
+  std::vector<Spill> make_spills(const std::vector<std::vector<int16_t>>& groups) const;
+  Spill stats_spill(const std::vector<int16_t>& channels, StatsUpdate::Type type,
+                    boost::posix_time::ptime time) const;
+};
+
+}
@@ -1,5 +1,6 @@
 #include "custom_logger.h"
 #include <boost/algorithm/string.hpp>
+#include <fstream>
 #include "cpx.h"
 
 const int MAX_CHARS_PER_LINE = 512;
@@ -40,6 +41,7 @@ int main(int argc, char *argv[])
 
   if (!parse_file(gabfile, program, cmd_params)) {
     ERR << "<cpx> parsing failed. Aborting";
+    CustomLogger::closeLogger();
     return 1;
   }
 
@@ -47,9 +49,14 @@ int main(int argc, char *argv[])
   std::vector<double> variables;
   if (!interpreter.interpret(program, variables)) {
     ERR << "<cpx> interpreting failed. Aborting";
+    CustomLogger::closeLogger();
     return 1;
   }
 
+  LINFO << "<cpx> " << Engine::getInstance().metrics().to_string();
+
+  //drain queued records before exit
+  CustomLogger::closeLogger();
   return 0;
 }
 
@@ -154,8 +161,14 @@ bool Cpx::interpret(std::list<CpxLine> commands, std::vector<double> variables)
       success = templates(line.params);
     else if (line.command == "run_mca")
       success = run_mca(line.params);
+    else if (line.command == "parallel")
+      success = parallel(line.params);
+    else if (line.command == "queue")
+      success = queue(line.params);
     else if (line.command == "save_qpx")
       success = save_qpx(line.params);
+    else if (line.command == "metrics")
+      success = metrics(line.params);
     else if (line.command == "endfor") {
       if (variables.size())
         return true;
@@ -232,6 +245,39 @@ bool Cpx::run_mca(std::vector<std::string> &tokens) {
   return true;
 }
 
+bool Cpx::parallel(std::vector<std::string> &tokens) {
+  if ((tokens.size() < 1) || ((tokens[0] != "on") && (tokens[0] != "off"))) {
+    ERR << "<cpx> expected syntax: parallel on|off";
+    return false;
+  }
+
+  spectra_->set_parallel_dispatch(tokens[0] == "on");
+  LINFO << "<cpx> parallel dispatch to sinks " << tokens[0];
+  return true;
+}
+
+bool Cpx::queue(std::vector<std::string> &tokens) {
+  std::map<std::string, Qpx::BoundedSpillQueue::Policy> policies {
+    {"block", Qpx::BoundedSpillQueue::Policy::block},
+    {"drop",  Qpx::BoundedSpillQueue::Policy::drop},
+    {"disk",  Qpx::BoundedSpillQueue::Policy::spill_to_disk}
+  };
+
+  if ((tokens.size() < 2) || !policies.count(tokens[1])) {
+    ERR << "<cpx> expected syntax: queue capacity block|drop|disk [overflow_dir]";
+    return false;
+  }
+
+  size_t capacity = boost::lexical_cast<size_t>(tokens[0]);
+  std::string overflow_dir;
+  if (tokens.size() > 2)
+    overflow_dir = tokens[2];
+
+  engine_.set_spill_queue(capacity, policies.at(tokens[1]), overflow_dir);
+  LINFO << "<cpx> spill queue capacity " << capacity << ", when full " << tokens[1];
+  return true;
+}
+
 bool Cpx::save_qpx(std::vector<std::string> &tokens) {
   if (tokens.size() < 1) {
     ERR << "<cpx> expected syntax: save_qpx filename(.qpx)";
@@ -250,6 +296,24 @@ bool Cpx::save_qpx(std::vector<std::string> &tokens) {
   return true;
 }
 
+bool Cpx::metrics(std::vector<std::string> &tokens) {
+  if (tokens.size() < 1) {
+    ERR << "<cpx> expected syntax: metrics filename(.json)";
+    return false;
+  }
+  std::string full_name = tokens[0] + ".json";
+  std::ofstream file(full_name);
+  if (!file.good()) {
+    ERR << "<cpx> could not open " << full_name;
+    return false;
+  }
+
+  LINFO << "<cpx> writing pipeline metrics of last run to " << full_name;
+  json j = engine_.metrics();
+  file << j.dump(1);
+  return true;
+}
+
 bool Cpx::boot(std::vector<std::string> &tokens) {
   if (tokens.size() < 2) {
     ERR << "<cpx> expected syntax: boot [path/profile.set] [path/settingsdir]";
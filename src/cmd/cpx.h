@@ -22,7 +22,10 @@ private:
   bool boot(std::vector<std::string> &tokens);
   bool templates(std::vector<std::string> &tokens);
   bool run_mca(std::vector<std::string> &tokens);
+  bool parallel(std::vector<std::string> &tokens);
+  bool queue(std::vector<std::string> &tokens);
   bool save_qpx(std::vector<std::string> &tokens);
+  bool metrics(std::vector<std::string> &tokens);
 
   Qpx::ProjectPtr   spectra_;
   Qpx::Engine       &engine_;
@@ -88,7 +88,7 @@ PreciseFloat Delayometer::_data(std::initializer_list<uint16_t> list) const {
     return 0;
 }
 
-std::unique_ptr<std::list<Entry>> Delayometer::_data_range(std::initializer_list<Pair> /*list*/)
+void Delayometer::_data_columns(std::initializer_list<Pair> /*list*/, DataColumns& out) const
 {
 //  int min, max;
 //  if (list.size() != 1) {
@@ -102,18 +102,13 @@ std::unique_ptr<std::list<Entry>> Delayometer::_data_range(std::initializer_list
 
 //  //in range?
   
-  std::unique_ptr<std::list<Entry>> result(new std::list<Entry>);
-  int i = 0;
+  out.reserve(spectrum_.size());
+  size_t i = 0;
   for (auto &q : spectrum_)
   {
-    Entry newentry;
-    newentry.first.resize(1, 0);
-    newentry.first[0] = i;
-    newentry.second = q.second.counts;
-    result->push_back(newentry);
+    out.push(i, q.second.counts);
     i++;
   }
-  return result;
 }
 
 void Delayometer::_append(const Entry& /*e*/)
@@ -127,12 +122,11 @@ void Delayometer::_append(const Entry& /*e*/)
 
 void Delayometer::_push_hit(const Hit& newhit)
 {
-  if ((newhit.source_channel() < 0)
-      || (newhit.source_channel() >= static_cast<int16_t>(energy_idx_.size()))
-      || (energy_idx_.at(newhit.source_channel()) < 0))
+  const ChannelPlan* plan = plan_.find(newhit.source_channel());
+  if (!plan || (plan->value_idx < 0))
     return;
 
-  DigitizedVal energy = newhit.value(energy_idx_.at(newhit.source_channel()));
+  DigitizedVal energy = newhit.value(plan->value_idx);
 
   if ((newhit.source_channel() < static_cast<int16_t>(cutoff_logic_.size()))
       && (energy.val(energy.bits()) < cutoff_logic_[newhit.source_channel()]))
@@ -151,14 +145,10 @@ void Delayometer::_push_hit(const Hit& newhit)
   for (auto &q : backlog) {
     if (q.in_window(newhit)) {
       Event copy = q;
-      if (copy.addHit(newhit)) {
-        if (validateEvent(copy)) {
-          recent_count_++;
-          total_events_++;
-          this->addEvent(copy);
-        } else
-          DBG << "<" << metadata_.get_attribute("name").value_text
-              << "> not validated " << q.to_string();
+      if (copy.addHit(newhit) && validateEvent(copy)) {
+        recent_count_++;
+        total_events_++;
+        this->addEvent(copy);
       }
 //      else
 //        DBG << "<" << metadata_.name << "> pileup hit " << newhit.to_string() << " with " << q.to_string() << " already has " << q.hits[newhit.source_channel()].to_string();
@@ -166,8 +156,7 @@ void Delayometer::_push_hit(const Hit& newhit)
 //    else if (q.past_due(newhit))
 //      break;
     else if (q.antecedent(newhit))
-      DBG << "<" << metadata_.get_attribute("name").value_text
-          << "> antecedent hit " << newhit.to_string() << ". Something wrong with presorter or daq_device?";
+      builder_.diagnostics().record(BuildDiagnostics::Anomaly::antecedent, newhit);
   }
 
   backlog.push_back(Event(newhit, coinc_window_, max_delay_));
@@ -181,9 +170,9 @@ void Delayometer::addEvent(const Event& newEvent) {
   Hit a, b;
   for (auto &h : newEvent.hits) {
     if (a == Hit())
-      a = h.second;
+      a = h;
     else
-      b = h.second;
+      b = h;
   }
 
 //  double df = std::abs(b.timestamp - a.timestamp);
@@ -40,20 +40,33 @@ class Delayometer : public Spectrum
 
 public:
   Delayometer();
+  //backlog false leaves out events still waiting for coincidence, for snapshots
+  Delayometer(const Delayometer& other, bool backlog_too = true)
+    : Spectrum(other)
+    , spectrum_(other.spectrum_)
+    , maxchan_(other.maxchan_)
+    , timebase(other.timebase)
+  {
+    if (backlog_too)
+      backlog = other.backlog;
+  }
   Delayometer* clone() const override { return new Delayometer(*this); }
 
 protected:
   std::string my_type() const override {return "Delayometer";}
 
   bool _initialize() override;
+  Consumer* _snapshot_copy() const override { return new Delayometer(*this, false); }
 
   PreciseFloat _data(std::initializer_list<uint16_t> list) const;
-  std::unique_ptr<std::list<Entry>> _data_range(std::initializer_list<Pair> list) override;
+  void _data_columns(std::initializer_list<Pair> list, DataColumns& out) const override;
   void _append(const Entry&) override;
   void _set_detectors(const std::vector<Qpx::Detector>& dets) override;
 
   //event processing
   void _push_hit(const Hit&) override;
+  void _push_hits(const HitBatch& hits) override { Consumer::_push_hits(hits); }
+  bool _coincidence_setup(CoincidenceSetup&) const override {return false;}
 
   void addEvent(const Event&) override;
 
@@ -66,6 +79,7 @@ protected:
   #endif
 
   std::map<int64_t, SpectrumItem> spectrum_;
+  std::list<Event> backlog;
 
   double maxchan_;
   TimeStamp timebase;
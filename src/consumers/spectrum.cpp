@@ -52,6 +52,30 @@ Spectrum::Spectrum()
   totalev.value_precise = 0;
   attributes.branches.add(totalev);
 
+  Setting multiple;
+  multiple.id_ = "multiple_coincidences";
+  multiple.metadata.setting_type = SettingType::floating_precise;
+  multiple.metadata.description = "Hits coincident with more than one other hit (counted >=2 times)";
+  multiple.metadata.writable = false;
+  multiple.value_precise = 0;
+  attributes.branches.add(multiple);
+
+  Setting pileup;
+  pileup.id_ = "pileup_hits";
+  pileup.metadata.setting_type = SettingType::floating_precise;
+  pileup.metadata.description = "Hits on a channel already present in coincident event";
+  pileup.metadata.writable = false;
+  pileup.value_precise = 0;
+  attributes.branches.add(pileup);
+
+  Setting antecedent;
+  antecedent.id_ = "antecedent_hits";
+  antecedent.metadata.setting_type = SettingType::floating_precise;
+  antecedent.metadata.description = "Hits preceding an open event (presorter or device out of order)";
+  antecedent.metadata.writable = false;
+  antecedent.value_precise = 0;
+  attributes.branches.add(antecedent);
+
 
   Qpx::Setting res;
   res.id_ = "resolution";
@@ -209,74 +233,67 @@ bool Spectrum::_initialize() {
   max_delay_ += coinc_window_;
   //   DBG << "<" << metadata_.name << "> coinc " << coinc_window_ << " max delay " << max_delay_;
 
+  coinc_setup_ = CoincidenceSetup();
+  coinc_setup_.coinc_window = coinc_window_;
+  coinc_setup_.bits = bits_;
+  coinc_setup_.delay_ns = delay_ns_;
+  coinc_setup_.cutoff_logic = cutoff_logic_;
+  size_t chans = std::max(pattern_coinc_.gates().size(),
+                          std::max(pattern_anti_.gates().size(), pattern_add_.gates().size()));
+  coinc_setup_.relevant.resize(chans, false);
+  for (size_t i=0; i < chans; ++i)
+    coinc_setup_.relevant[i] = (pattern_coinc_.relevant(i) ||
+                                pattern_anti_.relevant(i) ||
+                                pattern_add_.relevant(i));
+  relevant_mask_ = pattern_coinc_.mask() | pattern_anti_.mask() | pattern_add_.mask();
+  plan_.clear();
+  builder_ = EventBuilder(coinc_setup_);
+  shared_counts_ = BuildCounts();
+
   return false; //still too abstract
 }
 
+bool Spectrum::_coincidence_setup(CoincidenceSetup& setup) const
+{
+  setup = coinc_setup_;
+  return true;
+}
 
 void Spectrum::_push_hit(const Hit& newhit)
 {
-  if ((newhit.source_channel() < 0)
-      || (newhit.source_channel() >= static_cast<int16_t>(energy_idx_.size())))
+  int16_t chan = newhit.source_channel();
+  if (ChannelMask::in_range(chan) ? !relevant_mask_.test(chan)
+                                  : !coinc_setup_.is_relevant(chan))
     return;
 
-  if ((newhit.source_channel() < static_cast<int16_t>(cutoff_logic_.size()))
-      && (newhit.value(energy_idx_.at(newhit.source_channel())).val(bits_) < cutoff_logic_[newhit.source_channel()]))
+  builder_.push_hit(newhit, built_);
+  if (built_.empty())
     return;
+  this->_add_events(Span<Event>(built_));
+  built_.clear();
+}
 
-  if (newhit.source_channel() < 0)
-    return;
+void Spectrum::_push_hits(const HitBatch& hits)
+{
+  //irrelevant and cut hits are skipped on the columns, without materializing
+  builder_.push_hits(hits, built_);
 
-  if (!(pattern_coinc_.relevant(newhit.source_channel()) ||
-        pattern_anti_.relevant(newhit.source_channel()) ||
-        pattern_add_.relevant(newhit.source_channel())))
+  //events of the whole batch are handed over at once
+  if (built_.empty())
     return;
+  this->_add_events(Span<Event>(built_));
+  built_.clear();
+}
 
-  //  DBG << "Processing " << newhit.to_string();
-
-  Hit hit = newhit;
-  if (hit.source_channel() < static_cast<int16_t>(delay_ns_.size()))
-    hit.delay_ns(delay_ns_[hit.source_channel()]);
-
-  bool appended = false;
-  bool pileup = false;
-  if (backlog.empty() || backlog.back().past_due(hit))
-    backlog.push_back(Event(hit, coinc_window_, max_delay_));
-  else {
-    for (auto &q : backlog) {
-      if (q.in_window(hit)) {
-        if (q.addHit(hit)) {
-          if (appended)
-            DBG << "<" << metadata_.get_attribute("name").value_text << "> "
-                << "hit " << hit.to_string() << " coincident with more than one other hit (counted >=2 times)";
-          appended = true;
-        } else {
-          DBG << "<" << metadata_.get_attribute("name").value_text << "> "
-              << "pileup hit " << hit.to_string() << " with " << q.to_string() << " already has " << q.hits[hit.source_channel()].to_string();
-          pileup = true;
-        }
-      } else if (q.past_due(hit))
-        break;
-      else if (q.antecedent(hit))
-        DBG << "<" << metadata_.get_attribute("name").value_text << "> "
-            << "antecedent hit " << hit.to_string() << ". Something wrong with presorter or daq_device?";
-    }
-
-    if (!appended && !pileup) {
-      backlog.push_back(Event(hit, coinc_window_, max_delay_));
-      //      DBG << "append fresh";
-    }
-  }
-
-  Event evt;
-  while (!backlog.empty() && (evt = backlog.front()).past_due(hit)) {
-    backlog.pop_front();
+void Spectrum::_add_events(Span<Event> events)
+{
+  for (auto &evt : events) {
     if (validateEvent(evt)) {
       recent_count_++;
       total_events_++;
       this->addEvent(evt);
     }
   }
-
 }
 
 
@@ -299,119 +316,134 @@ void Spectrum::_push_stats(const StatsUpdate& newBlock) {
     return;
 
   //DBG << "Spectrum " << metadata_.name << " received update for chan " << newBlock.channel;
-  bool chan_new = (stats_list_.count(newBlock.source_channel) == 0);
   bool new_start = (newBlock.stats_type == StatsUpdate::Type::start);
 
-  if (newBlock.source_channel >= static_cast<int16_t>(energy_idx_.size()))
-    energy_idx_.resize(newBlock.source_channel + 1, -1);
-  if (newBlock.model_hit.name_to_idx.count("energy"))
-    energy_idx_[newBlock.source_channel] = newBlock.model_hit.name_to_idx.at("energy");
+  int16_t chan = newBlock.source_channel;
+  if (new_start || !plan_.find(chan))
+    plan_.compile(chan, newBlock.model_hit, bits_,
+                  (chan < static_cast<int16_t>(cutoff_logic_.size())) ? cutoff_logic_[chan] : 0,
+                  (chan < static_cast<int16_t>(delay_ns_.size())) ? delay_ns_[chan] : 0,
+                  ChannelMask::in_range(chan) ? relevant_mask_.test(chan) : coinc_setup_.is_relevant(chan));
 
-  Setting start_time = metadata_.get_attribute("start_time");
-  if (new_start && start_time.value_time.is_not_a_date_time()) {
-    start_time.value_time = newBlock.lab_time;
-    metadata_.set_attribute(start_time);
-  }
+  builder_.push_stats(newBlock);
 
-  if (!chan_new
-      && new_start
-      && (stats_list_[newBlock.source_channel].back().stats_type == StatsUpdate::Type::running))
-    stats_list_[newBlock.source_channel].back().stats_type = StatsUpdate::Type::stop;
+  Setting* start_time = metadata_.attribute(start_time_attr_);
+  if (new_start && start_time && start_time->value_time.is_not_a_date_time())
+    start_time->value_time = newBlock.lab_time;
 
-  if (recent_end_.lab_time.is_not_a_date_time())
-    recent_start_ = newBlock;
+  if (recent_end_.is_not_a_date_time())
+    recent_start_ = newBlock.lab_time;
   else
     recent_start_ = recent_end_;
+  recent_end_ = newBlock.lab_time;
 
-  recent_end_ = newBlock;
-
-  Setting rate = metadata_.get_attribute("instant_rate");
-  rate.value_dbl = 0;
-  double recent_time = (recent_end_.lab_time - recent_start_.lab_time).total_milliseconds() * 0.001;
+  instant_rate_ = 0;
+  double recent_time = (recent_end_ - recent_start_).total_milliseconds() * 0.001;
   if (recent_time > 0)
-    rate.value_dbl = recent_count_ / recent_time;
-  metadata_.set_attribute(rate);
-
+    instant_rate_ = recent_count_ / recent_time;
   recent_count_ = 0;
 
-  if (!chan_new && (stats_list_[newBlock.source_channel].back().stats_type == StatsUpdate::Type::running))
-    stats_list_[newBlock.source_channel].pop_back();
-
-  stats_list_[newBlock.source_channel].push_back(newBlock);
-
-  if (!chan_new) {
-    StatsUpdate start = stats_list_[newBlock.source_channel].front();
-
-    boost::posix_time::time_duration rt ,lt;
-    boost::posix_time::time_duration real ,live;
-
-    for (auto &q : stats_list_[newBlock.source_channel]) {
-      if (q.stats_type == StatsUpdate::Type::start) {
-        real += rt;
-        live += lt;
-        start = q;
-      } else {
-        lt = rt = q.lab_time - start.lab_time;
-        StatsUpdate diff = q - start;
-        PreciseFloat scale_factor = 1;
-        if (diff.items.count("native_time") && (diff.items.at("native_time") > 0))
-          scale_factor = rt.total_microseconds() / diff.items["native_time"];
-        if (diff.items.count("live_time")) {
-          PreciseFloat scaled_live = diff.items.at("live_time") * scale_factor;
-          lt = boost::posix_time::microseconds(static_cast<double>(scaled_live));
-        }
-      }
-    }
+  clocks_[newBlock.source_channel].push(newBlock);
 
-    if (stats_list_[newBlock.source_channel].back().stats_type != StatsUpdate::Type::start) {
-      real += rt;
-      live += lt;
-      //        DBG << "<Spectrum> \"" << metadata_.name << "\" RT + "
-      //               << rt << " = " << real << "   LT + " << lt << " = " << live;
-    }
-    real_times_[newBlock.source_channel] = real;
-    live_times_[newBlock.source_channel] = live;
-
-    Setting live_time = metadata_.get_attribute("live_time");
-    Setting real_time = metadata_.get_attribute("real_time");
+  if ((newBlock.stats_type != StatsUpdate::Type::running)
+      || times_published_.is_not_a_date_time()
+      || ((newBlock.lab_time - times_published_).total_milliseconds() >= kPublishMs))
+  {
+    publish_times();
+    update_totals();
+    update_build_counts(false);
+    times_published_ = newBlock.lab_time;
+  }
+}
 
-    live_time.value_duration = real_time.value_duration = real;
-    for (auto &q : real_times_)
-      if (q.second.total_milliseconds() < real_time.value_duration.total_milliseconds())
-        real_time.value_duration = q.second;
 
-    for (auto &q : live_times_)
-      if (q.second.total_milliseconds() < live_time.value_duration.total_milliseconds())
-        live_time.value_duration = q.second;
+void Spectrum::_flush()
+{
+  publish_times();
+  update_totals();
+  update_build_counts(true);
+}
 
-    metadata_.set_attribute(live_time);
-    metadata_.set_attribute(real_time);
+void Spectrum::ChannelClock::push(const StatsUpdate& block)
+{
+  if (block.stats_type == StatsUpdate::Type::start)
+  {
+    closed_real += open_real;
+    closed_live += open_live;
+    open_real = open_live = boost::posix_time::time_duration();
+    timed = timed || !segment_start.lab_time.is_not_a_date_time();
+    segment_start = block;
+    return;
+  }
 
-    //      DBG << "<Spectrum> \"" << metadata_.name << "\"  ********* "
-    //             << "RT = " << to_simple_string(metadata_.real_time)
-    //             << "   LT = " << to_simple_string(metadata_.live_time) ;
+  if (segment_start.lab_time.is_not_a_date_time())
+  {
+    //joined mid-run; count from here
+    segment_start = block;
+    return;
+  }
 
+  timed = true;
+  open_live = open_real = block.lab_time - segment_start.lab_time;
+  StatsUpdate diff = block - segment_start;
+  PreciseFloat scale_factor = 1;
+  if (diff.items.count(StatsKey::native_time) && (diff.items.at(StatsKey::native_time) > 0))
+    scale_factor = open_real.total_microseconds() / diff.items[StatsKey::native_time];
+  if (diff.items.count(StatsKey::live_time)) {
+    PreciseFloat scaled_live = diff.items.at(StatsKey::live_time) * scale_factor;
+    open_live = boost::posix_time::microseconds(static_cast<double>(scaled_live));
   }
+}
 
-  Setting res = metadata_.get_attribute("total_hits");
-  res.value_precise = total_hits_;
-  metadata_.set_attribute(res);
+void Spectrum::publish_times()
+{
+  if (Setting* rate = metadata_.attribute(instant_rate_attr_))
+    rate->value_dbl = instant_rate_;
 
-  Setting res2 = metadata_.get_attribute("total_events");
-  res2.value_precise = total_events_;
-  metadata_.set_attribute(res2);
-}
+  //the spectrum is only as old as its least exposed channel
+  bool any = false;
+  boost::posix_time::time_duration real, live;
+  for (auto &c : clocks_)
+  {
+    if (!c.second.timed)
+      continue;
+    if (!any || (c.second.real() < real))
+      real = c.second.real();
+    if (!any || (c.second.live() < live))
+      live = c.second.live();
+    any = true;
+  }
+  if (!any)
+    return;
 
+  if (Setting* live_time = metadata_.attribute(live_time_attr_))
+    live_time->value_duration = live;
+  if (Setting* real_time = metadata_.attribute(real_time_attr_))
+    real_time->value_duration = real;
+}
 
-void Spectrum::_flush()
+void Spectrum::update_totals()
 {
-  Setting res = metadata_.get_attribute("total_hits");
-  res.value_precise = total_hits_;
-  metadata_.set_attribute(res);
+  if (Setting* hits = metadata_.attribute(total_hits_attr_))
+    hits->value_precise = total_hits_;
+  if (Setting* events = metadata_.attribute(total_events_attr_))
+    events->value_precise = total_events_;
+}
 
-  Setting res2 = metadata_.get_attribute("total_events");
-  res2.value_precise = total_events_;
-  metadata_.set_attribute(res2);
+void Spectrum::update_build_counts(bool force_report)
+{
+  BuildCounts counts = builder_.diagnostics().counts();
+  counts += shared_counts_;
+
+  if (Setting* multiple = metadata_.attribute(multiple_attr_))
+    multiple->value_precise = counts.multiple;
+  if (Setting* pileup = metadata_.attribute(pileup_attr_))
+    pileup->value_precise = counts.pileup;
+  if (Setting* antecedent = metadata_.attribute(antecedent_attr_))
+    antecedent->value_precise = counts.antecedent;
+
+  if (force_report || builder_.diagnostics().due())
+    builder_.diagnostics().report("\"" + metadata_.get_attribute("name").value_text + "\"");
 }
 
 void Spectrum::_set_detectors(const std::vector<Qpx::Detector>& dets)
@@ -31,9 +31,45 @@
 #pragma once
 
 #include "consumer.h"
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+//bin counter for histograms of raw counts
+//#define QPX_BIN_COUNT32 1
 
 namespace Qpx {
 
+#ifdef QPX_BIN_COUNT32
+typedef uint32_t BinCount;
+#else
+typedef uint64_t BinCount;
+#endif
+
+//weight of an appended entry as a bin increment; integer bins take the
+//nearest whole count, saturating, and refuse negative or NaN weights
+template <typename Count>
+inline typename std::enable_if<std::is_integral<Count>::value, bool>::type
+to_bin_count(PreciseFloat weight, Count& count)
+{
+  double rounded = std::round(to_double(weight));
+  if (!(rounded >= 0))
+    return false;
+  if (rounded >= static_cast<double>(std::numeric_limits<Count>::max()))
+    count = std::numeric_limits<Count>::max();
+  else
+    count = static_cast<Count>(rounded);
+  return true;
+}
+
+template <typename Count>
+inline typename std::enable_if<!std::is_integral<Count>::value, bool>::type
+to_bin_count(PreciseFloat weight, Count& count)
+{
+  count = weight;
+  return true;
+}
+
 class Spectrum : public Consumer
 {
 public:
@@ -42,15 +78,36 @@ public:
 protected:
   bool _initialize() override;
   void _push_hit(const Hit&) override;
+  void _push_hits(const HitBatch&) override;
+  void _add_events(Span<Event>) override;
   void _push_stats(const StatsUpdate&) override;
+  void _set_build_counts(const BuildCounts& counts) override { shared_counts_ = counts; }
   void _flush() override;
 
+  bool _coincidence_setup(CoincidenceSetup&) const override;
+
   void _set_detectors(const std::vector<Qpx::Detector>& dets) override;
   void _recalc_axes() override;
 
   virtual bool validateEvent(const Event&) const;
   virtual void addEvent(const Event&) = 0;
 
+  //batch path for sinks that override _add_events with a non-virtual
+  //fill, e.g. [this](const Event& e){ fill_event(e); }; validation and
+  //event counting are the same as in Spectrum::_add_events
+  template <typename Fill>
+  inline void fill_events(Span<Event> events, Fill fill)
+  {
+    for (const Event& evt : events)
+    {
+      if (!pattern_coinc_.validate(evt) || !pattern_anti_.antivalidate(evt))
+        continue;
+      recent_count_++;
+      total_events_++;
+      fill(evt);
+    }
+  }
+
 protected:
   std::vector<int32_t> cutoff_logic_;
   std::vector<double>  delay_ns_;
@@ -58,21 +115,66 @@ protected:
   double max_delay_;
   double coinc_window_;
 
-  std::map<int, std::list<StatsUpdate>> stats_list_;
-  std::map<int, boost::posix_time::time_duration> real_times_;
-  std::map<int, boost::posix_time::time_duration> live_times_;
-  std::vector<int> energy_idx_;
+  //running real and live time of one channel: closed acquisition
+  //segments plus the one still open, so each update is O(1)
+  struct ChannelClock
+  {
+    bool timed {false};  //false until a second update arrives
+    StatsUpdate segment_start;
+    boost::posix_time::time_duration closed_real, closed_live;
+    boost::posix_time::time_duration open_real, open_live;
+
+    void push(const StatsUpdate&);
+    boost::posix_time::time_duration real() const {return closed_real + open_real;}
+    boost::posix_time::time_duration live() const {return closed_live + open_live;}
+  };
+  std::map<int, ChannelClock> clocks_;
+  IngestPlan plan_;  //compiled per channel from start stats
+
+  //energy at bits_ resolution
+  inline uint16_t energy(const Hit& h) const
+  {
+    const ChannelPlan* plan = plan_.find(h.source_channel());
+    return plan ? plan->value(h) : 0;
+  }
 
-  std::list<Event> backlog;
+  CoincidenceSetup coinc_setup_;
+  ChannelMask relevant_mask_;  //coinc | anti | add
+  EventBuilder builder_;
+  EventBatch built_;
+  BuildCounts shared_counts_;  //from a shared builder, if events come prebuilt
+
+  //anomaly totals to attributes; summary to log when due
+  void update_build_counts(bool force_report);
 
   uint64_t recent_count_;
-  StatsUpdate recent_start_, recent_end_;
+  boost::posix_time::ptime recent_start_, recent_end_;
+  double instant_rate_ {0};
+
+  //times and rate go to attributes at most this often (lab time),
+  //and always at run boundaries and flush
+  static const int kPublishMs = 1000;
+  boost::posix_time::ptime times_published_;
+  virtual void publish_times();
 
   Pattern pattern_coinc_, pattern_anti_, pattern_add_;
   uint16_t bits_;
 
-  PreciseFloat total_hits_;
-  PreciseFloat total_events_;
+  uint64_t total_hits_ {0};
+  uint64_t total_events_ {0};
+
+  //attributes written on every stats update
+  SettingHandle start_time_attr_ {"start_time"};
+  SettingHandle live_time_attr_ {"live_time"};
+  SettingHandle real_time_attr_ {"real_time"};
+  SettingHandle instant_rate_attr_ {"instant_rate"};
+  SettingHandle total_hits_attr_ {"total_hits"};
+  SettingHandle total_events_attr_ {"total_events"};
+  SettingHandle multiple_attr_ {"multiple_coincidences"};
+  SettingHandle pileup_attr_ {"pileup_hits"};
+  SettingHandle antecedent_attr_ {"antecedent_hits"};
+
+  void update_totals();
 };
 
 }
@@ -31,7 +31,8 @@ namespace Qpx {
 
 static ConsumerRegistrar<Spectrum1D> registrar("1D");
 
-Spectrum1D::Spectrum1D()
+template <typename Count>
+Spectrum1DT<Count>::Spectrum1DT()
   : cutoff_bin_(0)
   , maxchan_(0)
 {
@@ -55,7 +56,8 @@ Spectrum1D::Spectrum1D()
 //  DBG << "<1D:" << metadata_.get_attribute("name").value_text << ">  made with dims=" << metadata_.dimensions();
 }
 
-void Spectrum1D::_set_detectors(const std::vector<Detector>& dets)
+template <typename Count>
+void Spectrum1DT<Count>::_set_detectors(const std::vector<Detector>& dets)
 {
 //  DBG << "<1D:" << metadata_.get_attribute("name").value_text << "> dims=" << metadata_.dimensions();
   metadata_.detectors.resize(metadata_.dimensions(), Detector());
@@ -76,7 +78,8 @@ void Spectrum1D::_set_detectors(const std::vector<Detector>& dets)
   this->_recalc_axes();
 }
 
-bool Spectrum1D::_initialize()
+template <typename Count>
+bool Spectrum1DT<Count>::_initialize()
 {
   Spectrum::_initialize();
 
@@ -84,12 +87,13 @@ bool Spectrum1D::_initialize()
 
   size_t size = pow(2, bits_);
   if (spectrum_.size() < size)
-    spectrum_.resize(size, PreciseFloat(0));
+    spectrum_.resize(size, Count(0));
 
   return true;
 }
 
-PreciseFloat Spectrum1D::_data(std::initializer_list<size_t> list) const
+template <typename Count>
+PreciseFloat Spectrum1DT<Count>::_data(std::initializer_list<size_t> list) const
 {
   if (list.size() != 1)
     return 0;
@@ -101,7 +105,8 @@ PreciseFloat Spectrum1D::_data(std::initializer_list<size_t> list) const
     return spectrum_[chan];
 }
 
-std::unique_ptr<std::list<Entry>> Spectrum1D::_data_range(std::initializer_list<Pair> list)
+template <typename Count>
+void Spectrum1DT<Count>::_data_columns(std::initializer_list<Pair> list, DataColumns& out) const
 {
   size_t min, max;
   if (list.size() != 1) {
@@ -113,53 +118,54 @@ std::unique_ptr<std::list<Entry>> Spectrum1D::_data_range(std::initializer_list<
     max = range.second;
   }
 
+  if (spectrum_.empty())
+    return;
   if (max >= spectrum_.size())
     max = spectrum_.size() - 1;
+  if (min > max)
+    return;
 
-  //in range?
-  
-  std::unique_ptr<std::list<Entry>> result(new std::list<Entry>);
-  for (size_t i=min; i <= max; i++) {
-    Entry newentry;
-    newentry.first.resize(1, 0);
-    newentry.first[0] = i;
-    newentry.second = spectrum_[i];
-    result->push_back(newentry);
-  }
-  return result;
+  out.reserve(max - min + 1);
+  for (size_t i=min; i <= max; i++)
+    out.push(i, spectrum_[i]);
 }
 
-void Spectrum1D::_append(const Entry& e)
+template <typename Count>
+void Spectrum1DT<Count>::_append(const Entry& e)
 {
-  if (e.first.size() && (e.first.at(0) < spectrum_.size()))
+  if (!e.first.size() || (e.first.at(0) >= spectrum_.size()))
+    return;
+
+  Count weight;
+  BinCount events;
+  if (!to_bin_count(e.second, weight) || !to_bin_count(e.second, events))
   {
-    spectrum_[e.first.at(0)] += e.second;
-    total_events_ += e.second;
-    total_hits_ += e.second;
+    WARN << "<Spectrum1D> Rejected negative count " << to_double(e.second)
+         << " at bin " << e.first.at(0);
+    return;
   }
+
+  spectrum_[e.first.at(0)] += weight;
+  total_events_ += events;
+  total_hits_ += events;
 }
 
-void Spectrum1D::addHit(const Hit& newHit)
+template <typename Count>
+void Spectrum1DT<Count>::addHit(const Hit& newHit)
 {
-  uint16_t en = newHit.value(energy_idx_.at(newHit.source_channel())).val(bits_);
-  if (en < cutoff_bin_)
-    return;
-
-  ++spectrum_[en];
-  total_hits_++;
-
-  if (en > maxchan_)
-    maxchan_ = en;
+  fill(newHit);
 }
 
-void Spectrum1D::addEvent(const Event& newEvent)
+template <typename Count>
+void Spectrum1DT<Count>::addEvent(const Event& newEvent)
 {
   for (auto &h : newEvent.hits)
-    if (pattern_add_.relevant(h.first))
-      this->addHit(h.second);
+    if (pattern_add_.relevant(h.source_channel()))
+      this->addHit(h);
 }
 
-bool Spectrum1D::_write_file(std::string dir, std::string format) const
+template <typename Count>
+bool Spectrum1DT<Count>::_write_file(std::string dir, std::string format) const
 {
   std::string name = metadata_.get_attribute("name").value_text;
   //change illegal characters
@@ -176,7 +182,8 @@ bool Spectrum1D::_write_file(std::string dir, std::string format) const
     return false;
 }
 
-bool Spectrum1D::_read_file(std::string name, std::string format)
+template <typename Count>
+bool Spectrum1DT<Count>::_read_file(std::string name, std::string format)
 {
 //  DBG << "Will try to make " << format;
 
@@ -202,7 +209,8 @@ bool Spectrum1D::_read_file(std::string name, std::string format)
     return false;
 }
 
-void Spectrum1D::init_from_file(std::string filename)
+template <typename Count>
+void Spectrum1DT<Count>::init_from_file(std::string filename)
 {
   pattern_coinc_.resize(1);
   pattern_coinc_.set_gates(std::vector<bool>({true}));
@@ -245,7 +253,8 @@ void Spectrum1D::init_from_file(std::string filename)
   metadata_.set_attribute(cts);
 }
 
-std::string Spectrum1D::_data_to_xml() const {
+template <typename Count>
+std::string Spectrum1DT<Count>::_data_to_xml() const {
   std::stringstream channeldata;
 
   PreciseFloat z_count = 0;
@@ -264,7 +273,8 @@ std::string Spectrum1D::_data_to_xml() const {
   return channeldata.str();
 }
 
-uint16_t Spectrum1D::_data_from_xml(const std::string& thisData)
+template <typename Count>
+uint16_t Spectrum1DT<Count>::_data_from_xml(const std::string& thisData)
 {
   std::stringstream channeldata(thisData);
 
@@ -284,7 +294,7 @@ uint16_t Spectrum1D::_data_from_xml(const std::string& thisData)
       PreciseFloat nr {0};
       try { nr = std::stold(numero); }
       catch(...) {}
-      spectrum_[i] = nr;
+      spectrum_[i] = static_cast<Count>(nr);
       i++;
     }
   }
@@ -293,7 +303,8 @@ uint16_t Spectrum1D::_data_from_xml(const std::string& thisData)
 }
 
 
-bool Spectrum1D::channels_from_string(std::istream &data_stream, bool compression)
+template <typename Count>
+bool Spectrum1DT<Count>::channels_from_string(std::istream &data_stream, bool compression)
 {
   std::list<Entry> entry_list;
 
@@ -349,15 +360,16 @@ bool Spectrum1D::channels_from_string(std::istream &data_stream, bool compressio
   spectrum_.resize(pow(2, bits_), 0);
       
   for (auto &q : entry_list) {
-    spectrum_[q.first[0]] = q.second;
-    total_hits_ += q.second;
+    spectrum_[q.first[0]] = static_cast<Count>(q.second);
+    total_hits_ += static_cast<uint64_t>(q.second);
   }
 
   return true;
 }
 
 
-bool Spectrum1D::read_xylib(std::string name, std::string ext)
+template <typename Count>
+bool Spectrum1DT<Count>::read_xylib(std::string name, std::string ext)
 {
   xylib::DataSet* newdata;
 
@@ -426,12 +438,12 @@ bool Spectrum1D::read_xylib(std::string name, std::string ext)
         double data = newdata->get_block(i)->get_column(column).get_value(k);
         PreciseFloat nr(data);
 
-        spectrum_.push_back(PreciseFloat(data));
+        spectrum_.push_back(static_cast<Count>(data));
 
         tempcount += data;
       }
     }
-    total_events_ = total_hits_ = tempcount;
+    total_events_ = total_hits_ = static_cast<uint64_t>(tempcount);
   }
 
   uint32_t resolution = spectrum_.size();
@@ -456,7 +468,8 @@ bool Spectrum1D::read_xylib(std::string name, std::string ext)
   return true;
 }
 
-bool Spectrum1D::read_tka(std::string name)
+template <typename Count>
+bool Spectrum1DT<Count>::read_tka(std::string name)
 {
   using namespace boost::algorithm;
   std::ifstream myfile(name, std::ios::in);
@@ -483,7 +496,8 @@ bool Spectrum1D::read_tka(std::string name)
   return true;
 }
 
-bool Spectrum1D::read_spe_radware(std::string name)
+template <typename Count>
+bool Spectrum1DT<Count>::read_spe_radware(std::string name)
 {
   //radware spe format
   std::ifstream myfile(name, std::ios::in | std::ios::binary);
@@ -569,8 +583,8 @@ bool Spectrum1D::read_spe_radware(std::string name)
   spectrum_.resize(pow(2, bits_), 0);
 
   for (auto &q : entry_list) {
-    spectrum_[q.first[0]] = q.second;
-    total_hits_ += q.second;
+    spectrum_[q.first[0]] = static_cast<Count>(q.second);
+    total_hits_ += static_cast<uint64_t>(q.second);
   }
   total_events_ = total_hits_;
 
@@ -580,7 +594,8 @@ bool Spectrum1D::read_spe_radware(std::string name)
 }
 
 
-bool Spectrum1D::read_spe_gammavision(std::string name)
+template <typename Count>
+bool Spectrum1DT<Count>::read_spe_gammavision(std::string name)
 {
   //gammavision plain text
   std::ifstream myfile(name, std::ios::in);
@@ -716,8 +731,8 @@ bool Spectrum1D::read_spe_gammavision(std::string name)
 
   for (auto &q : entry_list)
   {
-    spectrum_[q.first[0]] = q.second;
-    total_hits_ += q.second;
+    spectrum_[q.first[0]] = static_cast<Count>(q.second);
+    total_hits_ += static_cast<uint64_t>(q.second);
   }
   total_events_ = total_hits_;
 
@@ -737,7 +752,8 @@ bool Spectrum1D::read_spe_gammavision(std::string name)
   return true;
 }
 
-bool Spectrum1D::read_dat(std::string name)
+template <typename Count>
+bool Spectrum1DT<Count>::read_dat(std::string name)
 {
   std::ifstream myfile(name, std::ios::in);
   if (!myfile)
@@ -776,8 +792,8 @@ bool Spectrum1D::read_dat(std::string name)
   spectrum_.resize(pow(2, bits_), 0);
 
   for (auto &q : entry_list) {
-    spectrum_[q.first[0]] = q.second;
-    total_hits_ += q.second;
+    spectrum_[q.first[0]] = static_cast<Count>(q.second);
+    total_hits_ += static_cast<uint64_t>(q.second);
   }
   total_events_ = total_hits_;
 
@@ -794,7 +810,8 @@ bool Spectrum1D::read_dat(std::string name)
   return true;
 }
 
-bool Spectrum1D::read_n42(std::string filename)
+template <typename Count>
+bool Spectrum1DT<Count>::read_n42(std::string filename)
 {
   pugi::xml_document doc;
 
@@ -877,7 +894,8 @@ bool Spectrum1D::read_n42(std::string filename)
   return true;
 }
 
-bool Spectrum1D::read_ava(std::string filename)
+template <typename Count>
+bool Spectrum1DT<Count>::read_ava(std::string filename)
 {
   pugi::xml_document doc;
 
@@ -964,7 +982,8 @@ bool Spectrum1D::read_ava(std::string filename)
   return true;
 }
 
-void Spectrum1D::write_tka(std::string name) const
+template <typename Count>
+void Spectrum1DT<Count>::write_tka(std::string name) const
 {
   uint32_t range = (pow(2, bits_) - 2);
   std::ofstream myfile(name, std::ios::out | std::ios::app);
@@ -978,7 +997,8 @@ void Spectrum1D::write_tka(std::string name) const
   myfile.close();
 }
 
-void Spectrum1D::write_n42(std::string filename) const
+template <typename Count>
+void Spectrum1DT<Count>::write_n42(std::string filename) const
 {
   pugi::xml_document doc;
   pugi::xml_node root = doc.append_child();
@@ -1025,7 +1045,8 @@ void Spectrum1D::write_n42(std::string filename) const
     ERR << "<Spectrum1D> Failed to save " << filename;
 }
 
-void Spectrum1D::write_spe(std::string filename) const
+template <typename Count>
+void Spectrum1DT<Count>::write_spe(std::string filename) const
 {
   //radware format
   std::ofstream myfile(filename, std::ios::out | std::ios::trunc | std::ios::binary);
@@ -1067,7 +1088,8 @@ void Spectrum1D::write_spe(std::string filename) const
 }
 
 #ifdef H5_ENABLED
-void Spectrum1D::_load_data(H5CC::Group& g)
+template <typename Count>
+void Spectrum1DT<Count>::_load_data(H5CC::Group& g)
 {
   if (!g.has_dataset("data"))
     return;
@@ -1080,14 +1102,15 @@ void Spectrum1D::_load_data(H5CC::Group& g)
   dset.read(rdata, {rdata.size()}, {0});
 
   spectrum_.clear();
-  spectrum_.resize(pow(2, bits_), PreciseFloat(0));
+  spectrum_.resize(pow(2, bits_), Count(0));
   for (size_t i = 0; i < rdata.size(); i++)
-    spectrum_[i] = rdata[i];
+    spectrum_[i] = static_cast<Count>(rdata[i]);
 
   maxchan_ = rdata.size();
 }
 
-void Spectrum1D::_save_data(H5CC::Group& g) const
+template <typename Count>
+void Spectrum1DT<Count>::_save_data(H5CC::Group& g) const
 {
   std::vector<long double> d(maxchan_);
   for (uint32_t i = 0; i < maxchan_; i++)
@@ -1098,4 +1121,7 @@ void Spectrum1D::_save_data(H5CC::Group& g) const
 #endif
 
 
+template class Spectrum1DT<BinCount>;
+template class Spectrum1DT<PreciseFloat>;
+
 }
@@ -23,11 +23,13 @@
 
 namespace Qpx {
 
-class Spectrum1D : public Spectrum
+//Count is BinCount for raw counts, PreciseFloat for weighted spectra
+template <typename Count>
+class Spectrum1DT : public Spectrum
 {
 public:
-  Spectrum1D();
-  Spectrum1D* clone() const override { return new Spectrum1D(*this); }
+  Spectrum1DT();
+  Spectrum1DT* clone() const override { return new Spectrum1DT(*this); }
 
 protected:
   std::string my_type() const override {return "1D";}
@@ -35,14 +37,38 @@ protected:
   bool _initialize() override;
 
   PreciseFloat _data(std::initializer_list<size_t> list) const override;
-  std::unique_ptr<std::list<Entry>> _data_range(std::initializer_list<Pair> list) override;
+  void _data_columns(std::initializer_list<Pair> list, DataColumns& out) const override;
   void _append(const Entry&) override;
   void _set_detectors(const std::vector<Qpx::Detector>& dets) override;
 
   //event processing
+  void _add_events(Span<Event> events) override
+  { fill_events(events, [this](const Event& e) { fill_event(e); }); }
   void addEvent(const Event&) override;
   virtual void addHit(const Hit&);
 
+  //non-virtual, for the batch path; subclasses that override
+  //addHit must route _add_events back through Spectrum
+  inline void fill(const Hit& newHit)
+  {
+    uint16_t en = this->energy(newHit);
+    if (en < cutoff_bin_)
+      return;
+
+    ++spectrum_[en];
+    total_hits_++;
+
+    if (en > maxchan_)
+      maxchan_ = en;
+  }
+
+  inline void fill_event(const Event& newEvent)
+  {
+    for (auto &h : newEvent.hits)
+      if (pattern_add_.relevant(h.source_channel()))
+        fill(h);
+  }
+
   //save/load
   bool _write_file(std::string, std::string) const override;
   bool _read_file(std::string, std::string) override;
@@ -71,9 +97,11 @@ protected:
   bool read_spe_radware(std::string);
   bool read_spe_gammavision(std::string);
 
-  std::vector<PreciseFloat> spectrum_;
+  std::vector<Count> spectrum_;
   uint32_t cutoff_bin_;
   uint16_t maxchan_;
 };
 
+typedef Spectrum1DT<BinCount> Spectrum1D;
+
 }
@@ -31,7 +31,7 @@ namespace Qpx {
 static ConsumerRegistrar<Spectrum1D_LFC> registrar("LFC1D");
 
 Spectrum1D_LFC::Spectrum1D_LFC()
-  : Spectrum1D()
+  : Spectrum1DT<PreciseFloat>()
 {
   Setting base_options = metadata_.attributes();
   metadata_ = ConsumerMetadata("LFC1D", "One detector loss-free spectrum", 1,
@@ -54,7 +54,7 @@ Spectrum1D_LFC::Spectrum1D_LFC()
 }
 
 bool Spectrum1D_LFC::_initialize() {
-  if (!Spectrum1D::_initialize())
+  if (!Spectrum1DT<PreciseFloat>::_initialize())
     return false;
 
   //add pattern must have exactly one channel
@@ -83,15 +83,26 @@ bool Spectrum1D_LFC::_initialize() {
 
 void Spectrum1D_LFC::addHit(const Hit& newHit)
 {
-  uint16_t en = newHit.value(energy_idx_.at(newHit.source_channel())).val(bits_);
+  uint16_t en = energy(newHit);
   channels_run_[ en ] ++;
   count_current_++;
   total_hits_++;
 }
 
+void Spectrum1D_LFC::publish_times()
+{
+  Spectrum1DT<PreciseFloat>::publish_times();
+
+  //counts are already loss-corrected
+  Setting real_time = metadata_.get_attribute("real_time");
+  Setting live_time = metadata_.get_attribute("live_time");
+  live_time.value_duration = real_time.value_duration;
+  metadata_.set_attribute(live_time);
+}
+
 void Spectrum1D_LFC::_push_stats(const StatsUpdate& newStats)
 {
-  Spectrum1D::_push_stats(newStats);
+  Spectrum1DT<PreciseFloat>::_push_stats(newStats);
 
   if (newStats.source_channel != my_channel_)
     return;
@@ -110,26 +121,26 @@ void Spectrum1D_LFC::_push_stats(const StatsUpdate& newStats)
     time1_ = time2_;
 
     PreciseFloat scale_factor = 1;
-    if (diff.items.count("native_time") && (diff.items.at("native_time") > 0))
-      scale_factor = d_lab_time / diff.items.at("native_time");
+    if (diff.items.count(StatsKey::native_time) && (diff.items.at(StatsKey::native_time) > 0))
+      scale_factor = d_lab_time / diff.items.at(StatsKey::native_time);
 
     PreciseFloat live = d_lab_time;
-    if (diff.items.count("live_trigger"))
-      live = diff.items.at(("live_trigger"));
-    else if (diff.items.count("live_time"))
-      live = diff.items.at(("live_time"));
+    if (diff.items.count(StatsKey::live_trigger))
+      live = diff.items.at(StatsKey::live_trigger);
+    else if (diff.items.count(StatsKey::live_time))
+      live = diff.items.at(StatsKey::live_time);
 
     PreciseFloat fast_scaled  = live * scale_factor;
 
     PreciseFloat fast_peaks_compensated = count_current_;
 
-    if ((fast_scaled > 0) && diff.items.count("trigger_count"))
-      fast_peaks_compensated = diff.items.at("trigger_count") * d_lab_time / fast_scaled;
+    if ((fast_scaled > 0) && diff.items.count(StatsKey::trigger_count))
+      fast_peaks_compensated = diff.items.at(StatsKey::trigger_count) * d_lab_time / fast_scaled;
 
     time1_ = time2_;
 
     count_total_ += fast_peaks_compensated;
-    total_hits_ = count_total_;
+    total_hits_ = static_cast<uint64_t>(count_total_);
 
     DBG << "<SpectrumLFC1D> '" << metadata_.get_attribute("name").value_text
         << "' update chan[" << my_channel_ << "]"
@@ -143,11 +154,6 @@ void Spectrum1D_LFC::_push_stats(const StatsUpdate& newStats)
         spectrum_[i] = channels_all_[i];
       channels_run_[i] = 0.0;
     }
-    Setting real_time = metadata_.get_attribute("real_time");
-    Setting live_time = metadata_.get_attribute("live_time");
-    live_time.value_duration = real_time.value_duration;
-    metadata_.set_attribute(live_time);
-
     count_current_ = 0;
   } else {
     uint32_t res = pow(2, bits_);
@@ -155,7 +161,7 @@ void Spectrum1D_LFC::_push_stats(const StatsUpdate& newStats)
       if ((channels_run_[i] > 0.0) || (channels_all_[i] > 0.0))
         spectrum_[i] = channels_run_[i] + channels_all_[i];
     }
-    total_hits_ += count_current_;
+    total_hits_ += static_cast<uint64_t>(count_current_);
     time2_ = newStats;
   }
 }
@@ -27,7 +27,7 @@
 
 namespace Qpx {
 
-class Spectrum1D_LFC : public Spectrum1D
+class Spectrum1D_LFC : public Spectrum1DT<PreciseFloat>
 {
 public:
   Spectrum1D_LFC();
@@ -38,7 +38,10 @@ protected:
   bool _initialize() override;
   
   void _push_stats(const StatsUpdate&) override;
+  void publish_times() override;
 
+  //live-time correction is per hit, so events take the virtual path
+  void _add_events(Span<Event> events) override { Spectrum::_add_events(events); }
   void addHit(const Hit&) override;
 
 
@@ -39,12 +39,12 @@ SpectrumAddback1D::SpectrumAddback1D()
   metadata_.overwrite_all_attributes(base_options);
 }
 
-void SpectrumAddback1D::addEvent(const Event& newEvent)
+void SpectrumAddback1D::fill_event(const Event& newEvent)
 {
   uint32_t sum = 0;
   for (auto &h : newEvent.hits)
-    if (pattern_add_.relevant(h.first))
-      sum += h.second.value(energy_idx_.at(h.second.source_channel())).val(bits_);
+    if (pattern_add_.relevant(h.source_channel()))
+      sum += energy(h);
 
   if ((sum < cutoff_bin_) || (sum >= spectrum_.size()))
     return;
@@ -35,7 +35,10 @@ public:
 
 protected:
   std::string my_type() const override {return "Addback 1D";}
-  void addEvent(const Event&) override;
+  void _add_events(Span<Event> events) override
+  { fill_events(events, [this](const Event& e) { fill_event(e); }); }
+  void addEvent(const Event& e) override { fill_event(e); }
+  void fill_event(const Event&);
 };
 
 }
@@ -33,6 +33,7 @@ namespace Qpx {
 static ConsumerRegistrar<Spectrum2D> registrar("2D");
 
 Spectrum2D::Spectrum2D()
+  : epoch_(std::make_shared<boost::atomic<uint32_t>>(1))
 {
   Setting base_options = metadata_.attributes();
   metadata_ = ConsumerMetadata("2D", "2-dimensional coincidence matrix", 2,
@@ -137,13 +138,11 @@ void Spectrum2D::init_from_file(std::string filename) {
 
 bool Spectrum2D::check_symmetrization() {
   bool symmetrical = true;
-  for (auto &q : spectrum_) {
-    std::pair<uint16_t,uint16_t> point(q.first.second, q.first.first);
-    if ((!spectrum_.count(point)) || (spectrum_.at(point) != q.second)) {
+  const SpectrumMatrix& m = spectrum_;
+  m.for_each([&symmetrical, &m](uint16_t x, uint16_t y, BinCount c) {
+    if (symmetrical && (m.get(y, x) != c))
       symmetrical = false;
-      break;
-    }
-  }
+  });
   Setting symset = metadata_.get_attribute("symmetrized");
   symset.value_int = symmetrical;
   metadata_.set_attribute(symset);
@@ -173,12 +172,21 @@ void Spectrum2D::_set_detectors(const std::vector<Detector>& dets) {
 
 void Spectrum2D::_append(const Entry& e)
 {
-  if (e.first.size() == 2)
+  if (e.first.size() != 2)
+    return;
+
+  BinCount weight;
+  if (!to_bin_count(e.second, weight))
   {
-    spectrum_[std::pair<uint16_t,uint16_t>(e.first[0], e.first[1])] += e.second;
-    total_events_ += e.second;
-    total_hits_ += (2 * e.second);
+    WARN << "<Spectrum2D> Rejected negative count " << to_double(e.second)
+         << " at " << e.first[0] << "," << e.first[1];
+    return;
   }
+
+  sync_epoch();
+  spectrum_.add(e.first[0], e.first[1], weight);
+  total_events_ += weight;
+  total_hits_ += 2 * weight;
 }
 
 PreciseFloat Spectrum2D::_data(std::initializer_list<size_t> list) const {
@@ -186,16 +194,27 @@ PreciseFloat Spectrum2D::_data(std::initializer_list<size_t> list) const {
     return 0;
 
   std::vector<uint16_t> coords(list.begin(), list.end());
+  return spectrum_.get(coords[0], coords[1]);
+}
 
-  std::pair<uint16_t,uint16_t> point(coords[0], coords[1]);
+void Spectrum2D::_data_columns(std::initializer_list<Pair> list, DataColumns& out) const {
+  uint32_t since = 0;
+  read_tiles(list, since, out);
+}
 
-  if (spectrum_.count(point))
-    return spectrum_.at(point);
-  else
-    return 0;
+void Spectrum2D::_data_delta(std::initializer_list<Pair> list, uint32_t& since, DataColumns& out) const {
+  if (!buffered_) {
+    read_tiles(list, 0, out);
+    return;
+  }
+  //this copy holds every write stamped up to its own epoch
+  uint32_t upto = spectrum_.epoch() + 1;
+  if (since < upto)
+    read_tiles(list, since, out);
+  since = upto;
 }
 
-std::unique_ptr<EntryList> Spectrum2D::_data_range(std::initializer_list<Pair> list) {
+void Spectrum2D::read_tiles(std::initializer_list<Pair> list, uint32_t since, DataColumns& out) const {
   int min0, min1, max0, max1;
   if (list.size() != 2) {
     min0 = min1 = 0;
@@ -206,56 +225,27 @@ std::unique_ptr<EntryList> Spectrum2D::_data_range(std::initializer_list<Pair> l
     min1 = range1.first; max1 = range1.second;
   }
 
-  std::unique_ptr<std::list<Entry>> result(new std::list<Entry>);
-//  CustomTimer makelist(true);
-
-  if (buffered_ && !temp_spectrum_.empty()) {
-    for (auto it : temp_spectrum_) {
-      int co0 = it.first.first, co1 = it.first.second;
-      if ((min0 <= co0) && (co0 <= max0) && (min1 <= co1) && (co1 <= max1)) {
-        Entry newentry;
-        newentry.first.resize(2, 0);
-        newentry.first[0] = co0;
-        newentry.first[1] = co1;
-        newentry.second = it.second;
-        result->push_back(newentry);
-      }
-    }
-  } else {
-    for (auto it : spectrum_) {
-      int co0 = it.first.first, co1 = it.first.second;
-      if ((min0 <= co0) && (co0 <= max0) && (min1 <= co1) && (co1 <= max1)) {
-        Entry newentry;
-        newentry.first.resize(2, 0);
-        newentry.first[0] = co0;
-        newentry.first[1] = co1;
-        newentry.second = it.second;
-        result->push_back(newentry);
-      }
-    }
-  }
-  if (!temp_spectrum_.empty()) {
-    boost::unique_lock<boost::mutex> uniqueLock(unique_mutex_, boost::defer_lock);
-    while (!uniqueLock.try_lock())
-      boost::this_thread::sleep_for(boost::chrono::seconds{1});
-    temp_spectrum_.clear(); //assumption about client
-  }
-//  DBG << "<Spectrum2D> Making list for " << metadata_.name << " took " << makelist.ms() << "ms filled with "
-//         << result->size() << " elements";
-  return result;
+  if ((min0 < 0) || (min1 < 0) || (max0 < min0) || (max1 < min1))
+    return;
+
+  spectrum_.for_each([&out](uint16_t x, uint16_t y, BinCount c) {
+    out.push(x, y, c);
+  }, min0, max0, min1, max1, since);
+}
+
+void Spectrum2D::_snapshot_taken() const {
+  //writes after this are newer than anything the snapshot holds
+  (*epoch_)++;
 }
 
-void Spectrum2D::addEvent(const Event& newEvent) {
+void Spectrum2D::fill_event(const Event& newEvent) {
   uint16_t chan1_en = 0;
   uint16_t chan2_en = 0;
   if (newEvent.hits.count(pattern_[0]))
-    chan1_en = newEvent.hits.at(pattern_[0]).value(energy_idx_.at(pattern_[0])).val(bits_);
+    chan1_en = energy(newEvent.hits.at(pattern_[0]));
   if (newEvent.hits.count(pattern_[1]))
-    chan2_en = newEvent.hits.at(pattern_[1]).value(energy_idx_.at(pattern_[1])).val(bits_);
-  spectrum_[std::pair<uint16_t, uint16_t>(chan1_en,chan2_en)] += 1;
-  if (buffered_)
-    temp_spectrum_[std::pair<uint16_t, uint16_t>(chan1_en, chan2_en)] =
-        spectrum_[std::pair<uint16_t, uint16_t>(chan1_en, chan2_en)];
+    chan2_en = energy(newEvent.hits.at(pattern_[1]));
+  spectrum_.add(chan1_en, chan2_en);
   if (chan1_en)
     total_hits_++;
   if (chan2_en)
@@ -295,10 +285,11 @@ void Spectrum2D::write_m(std::string name) const {
          << "%  Bit precision: " << bits_ << std::endl
          << "%  Total events : " << total_events_ << std::endl
          << "clear;" << std::endl;
-  for (auto it = spectrum_.begin(); it != spectrum_.end(); ++it)
-    myfile << "coinc(" << (it->first.first + 1)
-           << ", " << (it->first.second + 1)
-           << ") = " << it->second << ";" << std::endl;
+  spectrum_.for_each([&myfile](uint16_t x, uint16_t y, BinCount c) {
+    myfile << "coinc(" << (x + 1)
+           << ", " << (y + 1)
+           << ") = " << c << ";" << std::endl;
+  });
 
   myfile << "figure;" << std::endl
          << "imagesc(log(coinc));" << std::endl
@@ -312,10 +303,7 @@ void Spectrum2D::write_m4b(std::string name) const {
   uint32_t one;
   for (int i=0; i<4096; ++i) {
     for (int j=0; j<4096; ++j) {
-      one = 0.0;
-      std::pair<uint16_t,uint16_t> point(i, j);
-      if (spectrum_.count(point))
-        one = static_cast<uint32_t>(spectrum_.at(point));
+      one = static_cast<uint32_t>(spectrum_.get(i, j));
 
       myfile.write((char*)&one, sizeof(uint32_t));
 
@@ -330,10 +318,7 @@ void Spectrum2D::write_mat(std::string name) const {
   uint16_t one;
   for (int i=0; i<4096; ++i) {
     for (int j=0; j<4096; ++j) {
-      one = 0;
-      std::pair<uint16_t,uint16_t> point(i, j);
-      if (spectrum_.count(point))
-        one = static_cast<uint16_t>(spectrum_.at(point));
+      one = static_cast<uint16_t>(spectrum_.get(i, j));
 
       myfile.write((char*)&one, sizeof(uint16_t));
 
@@ -358,7 +343,7 @@ bool Spectrum2D:: read_m4b(std::string name)
       myfile.read ((char*)&one, sizeof(uint32_t));
       total_events_ += one;
       if (one > 0)
-        spectrum_[std::pair<uint16_t, uint16_t>(i,j)] = one;
+        spectrum_.set(i, j, one);
     }
   }
   total_hits_ += total_events_ * 2;
@@ -393,7 +378,7 @@ bool Spectrum2D:: read_mat(std::string name)
       myfile.read ((char*)&one, sizeof(uint16_t));
       total_events_ += one;
       if (one > 0)
-        spectrum_[std::pair<uint16_t, uint16_t>(i,j)] = one;
+        spectrum_.set(i, j, one);
     }
   }
   total_hits_ = 2 * total_events_;
@@ -417,10 +402,8 @@ std::string Spectrum2D::_data_to_xml() const {
   std::stringstream channeldata;
 
   int i=0, j=0;
-  for (auto it = spectrum_.begin(); it != spectrum_.end(); ++it)
+  spectrum_.for_each([&](uint16_t this_i, uint16_t this_j, BinCount c)
   {
-    int this_i = it->first.first;
-    int this_j = it->first.second;
     if (this_i > i) {
       channeldata << "+ " << (this_i - i) << " ";
       if (this_j > 0)
@@ -430,9 +413,9 @@ std::string Spectrum2D::_data_to_xml() const {
     }
     if (this_j > j)
       channeldata << "0 " << (this_j - j) << " ";
-    channeldata << std::setprecision(std::numeric_limits<PreciseFloat>::max_digits10) << it->second  <<  " ";
+    channeldata << c <<  " ";
     j = this_j + 1;
-  }  
+  });
   return channeldata.str();
 }
 
@@ -456,7 +439,7 @@ uint16_t Spectrum2D::_data_from_xml(const std::string& thisData){
       channeldata >> numero_z;
       j += boost::lexical_cast<uint16_t>(numero_z);
     } else {
-      spectrum_[std::pair<uint16_t, uint16_t>(i,j)] = boost::lexical_cast<PreciseFloat>(numero);
+      spectrum_.set(i, j, static_cast<BinCount>(boost::lexical_cast<PreciseFloat>(numero)));
       j++;
     }
   }
@@ -466,23 +449,25 @@ uint16_t Spectrum2D::_data_from_xml(const std::string& thisData){
 #ifdef H5_ENABLED
 void Spectrum2D::_save_data(H5CC::Group& g) const
 {
+  //one H5 chunk per allocated tile
+  const size_t side = SpectrumMatrix::kTileSide;
+  const size_t tiles = spectrum_.tile_count();
   auto dgroup = g.require_group("data");
-  auto didx = dgroup.require_dataset<uint16_t>("indices", {spectrum_.size(), 2}, {128,2});
-  auto dcts = dgroup.require_dataset<long double>("counts", {spectrum_.size()}, {128});
-  std::vector<uint16_t> dx(spectrum_.size());
-  std::vector<uint16_t> dy(spectrum_.size());
-  std::vector<long double> dc(spectrum_.size());
+  auto dorg = dgroup.require_dataset<uint16_t>("tile_origins", {tiles, 2}, {128,2});
+  auto dtls = dgroup.require_dataset<BinCount>("tiles", {tiles, side, side}, {1, side, side});
+  std::vector<uint16_t> ox(tiles);
+  std::vector<uint16_t> oy(tiles);
   size_t i = 0;
-  for (auto it = spectrum_.begin(); it != spectrum_.end(); ++it)
+  spectrum_.for_each_tile([&](uint16_t x, uint16_t y, const BinCount* cells)
   {
-    dx[i] = it->first.first;
-    dy[i] = it->first.second;
-    dc[i] = static_cast<long double>(it->second);
+    ox[i] = x;
+    oy[i] = y;
+    std::vector<BinCount> tile(cells, cells + SpectrumMatrix::kTileCells);
+    dtls.write(tile, {1, side, side}, {i, 0, 0});
     i++;
-  }
-  didx.write(dx, {spectrum_.size(), 1}, {0,0});
-  didx.write(dy, {spectrum_.size(), 1}, {0,1});
-  dcts.write(dc);
+  });
+  dorg.write(ox, {tiles, 1}, {0,0});
+  dorg.write(oy, {tiles, 1}, {0,1});
 }
 
 void Spectrum2D::_load_data(H5CC::Group &g)
@@ -491,6 +476,34 @@ void Spectrum2D::_load_data(H5CC::Group &g)
     return;
   auto dgroup = g.open_group("data");
 
+  if (dgroup.has_dataset("tile_origins") && dgroup.has_dataset("tiles"))
+  {
+    const size_t side = SpectrumMatrix::kTileSide;
+    auto dorg = dgroup.open_dataset("tile_origins");
+    auto dtls = dgroup.open_dataset("tiles");
+    if ((dorg.shape().rank() != 2) ||
+        (dtls.shape().rank() != 3) ||
+        (dorg.shape().dim(0) != dtls.shape().dim(0)) ||
+        (dtls.shape().dim(1) != side) ||
+        (dtls.shape().dim(2) != side))
+      return;
+
+    size_t tiles = dorg.shape().dim(0);
+    std::vector<uint16_t> ox(tiles);
+    std::vector<uint16_t> oy(tiles);
+    dorg.read(ox, {tiles, 1}, {0,0});
+    dorg.read(oy, {tiles, 1}, {0,1});
+
+    std::vector<BinCount> tile(SpectrumMatrix::kTileCells);
+    for (size_t i=0; i < tiles; ++i)
+    {
+      dtls.read(tile, {1, side, side}, {i, 0, 0});
+      std::copy(tile.begin(), tile.end(), spectrum_.tile(ox[i], oy[i]));
+    }
+    return;
+  }
+
+  //indexed format of earlier versions
   if (!dgroup.has_dataset("indices") || !dgroup.has_dataset("counts"))
     return;
 
@@ -511,7 +524,7 @@ void Spectrum2D::_load_data(H5CC::Group &g)
   dcts.read(dc, {dx.size()}, {0});
 
   for (size_t i=0; i < dx.size(); ++i)
-    spectrum_[std::pair<uint16_t, uint16_t>(dx[i],dy[i])] = dc[i];
+    spectrum_.set(dx[i], dy[i], static_cast<BinCount>(dc[i]));
 }
 #endif
 
@@ -24,7 +24,7 @@
 #pragma once
 
 #include "spectrum.h"
-#include <unordered_map>
+#include "tiled_matrix.h"
 
 namespace Qpx {
 
@@ -35,7 +35,7 @@ public:
   Spectrum2D* clone() const override { return new Spectrum2D(*this); }
 
 protected:
-  typedef std::map<std::pair<uint16_t,uint16_t>, PreciseFloat> SpectrumMap2D;
+  typedef TiledMatrix<BinCount> SpectrumMatrix;
   
   bool _initialize() override;
   void init_from_file(std::string filename);
@@ -43,10 +43,15 @@ protected:
   std::string my_type() const override {return "2D";}
 
   PreciseFloat _data(std::initializer_list<size_t> list ) const override;
-  std::unique_ptr<EntryList> _data_range(std::initializer_list<Pair> list) override;
+  void _data_columns(std::initializer_list<Pair> list, DataColumns& out) const override;
+  void _data_delta(std::initializer_list<Pair> list, uint32_t& since, DataColumns& out) const override;
+  void _snapshot_taken() const override;
   void _set_detectors(const std::vector<Qpx::Detector>& dets) override;
 
-  void addEvent(const Event&) override;
+  void _add_events(Span<Event> events) override
+  { sync_epoch(); fill_events(events, [this](const Event& e) { fill_event(e); }); }
+  void addEvent(const Event& e) override { sync_epoch(); fill_event(e); }
+  void fill_event(const Event&);
   void _append(const Entry&) override;
 
   //save/load
@@ -72,11 +77,19 @@ protected:
   //indexes of the two chosen channels
   std::vector<int8_t> pattern_;
 
-  //the data itself
-  SpectrumMap2D spectrum_;
-  SpectrumMap2D temp_spectrum_;
+  //the data itself; in buffered mode, _data_delta returns only
+  //tiles written since the caller's epoch
+  SpectrumMatrix spectrum_;
   bool buffered_;
 
+  //shared by the live consumer and its snapshots: stamps writes,
+  //advanced each time a snapshot is published
+  std::shared_ptr<boost::atomic<uint32_t>> epoch_;
+
+  inline void sync_epoch() { spectrum_.set_epoch(epoch_->load()); }
+
+  void read_tiles(std::initializer_list<Pair> list, uint32_t since, DataColumns& out) const;
+
   bool check_symmetrization();
 };
 
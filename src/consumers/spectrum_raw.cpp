@@ -33,7 +33,7 @@ static ConsumerRegistrar<SpectrumRaw> registrar("Raw");
 
 SpectrumRaw::SpectrumRaw()
   : open_bin_(false)
-  , open_xml_(false)
+  , open_index_(false)
   , hits_this_spill_(0)
   , total_hits_(0)
   , ignore_patterns_(true)
@@ -50,6 +50,37 @@ SpectrumRaw::SpectrumRaw()
   file_setting.metadata.description = "path to temp output directory";
   base_options.branches.add(file_setting);
 
+  Qpx::Setting buffer_setting;
+  buffer_setting.id_ = "write_buffer_MB";
+  buffer_setting.metadata.setting_type = Qpx::SettingType::integer;
+  buffer_setting.metadata.writable = true;
+  buffer_setting.metadata.flags.insert("preset");
+  buffer_setting.metadata.description = "size of each output buffer handed to the writer thread";
+  buffer_setting.metadata.minimum = 1;
+  buffer_setting.metadata.step = 1;
+  buffer_setting.metadata.maximum = 1024;
+  buffer_setting.value_int = 4;
+  base_options.branches.add(buffer_setting);
+
+  Qpx::Setting prealloc_setting;
+  prealloc_setting.id_ = "preallocate_MB";
+  prealloc_setting.metadata.setting_type = Qpx::SettingType::integer;
+  prealloc_setting.metadata.writable = true;
+  prealloc_setting.metadata.flags.insert("preset");
+  prealloc_setting.metadata.description = "disk space reserved for output at start (0 = none)";
+  prealloc_setting.metadata.minimum = 0;
+  prealloc_setting.metadata.step = 1;
+  prealloc_setting.metadata.maximum = 1048576;
+  base_options.branches.add(prealloc_setting);
+
+  Qpx::Setting direct_setting;
+  direct_setting.id_ = "direct_io";
+  direct_setting.metadata.setting_type = Qpx::SettingType::boolean;
+  direct_setting.metadata.writable = true;
+  direct_setting.metadata.flags.insert("preset");
+  direct_setting.metadata.description = "write output bypassing the page cache";
+  base_options.branches.add(direct_setting);
+
   metadata_.overwrite_all_attributes(base_options);
 }
 
@@ -72,32 +103,34 @@ bool SpectrumRaw::_initialize() {
   return init_bin();
 }
 
-bool SpectrumRaw::init_text() {
-  file_name_txt_ = file_dir_ + "/qpx_out.xml";
-  xml_root_ = xml_doc_.append_child("QpxListData");
-
-  metadata_.attributes().to_xml(xml_root_);
+bool SpectrumRaw::init_index() {
+  file_name_idx_ = file_dir_ + "/" + ListIndexWriter::file_name;
+  if (!index_.open(file_name_idx_, metadata_.attributes()))
+    return false;
 
-  open_xml_ = true;
+  open_index_ = true;
   return true;
 }
 
 bool SpectrumRaw::init_bin() {
   file_name_bin_ = file_dir_ + "/qpx_out.bin";
 
-  file_bin_.open(file_name_bin_, std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+  ListWriter::Options options;
+  options.buffer_size = std::max<int64_t>(metadata_.get_attribute("write_buffer_MB").value_int, 1) << 20;
+  options.preallocate = std::max<int64_t>(metadata_.get_attribute("preallocate_MB").value_int, 0) << 20;
+  options.direct = metadata_.get_attribute("direct_io").value_int;
 
-  if (!file_bin_.is_open())
+  std::string name = metadata_.get_attribute("name").value_text;
+  if (!file_bin_.open(file_name_bin_, options, name))
     return false;
 
-  if (!file_bin_.good() || !init_text()) {
+  if (!init_index()) {
     file_bin_.close();
     return false;
   }
 
-  DBG << "<SpectrumRaw:" << metadata_.get_attribute("name").value_text << "> binary is good";
+  DBG << "<SpectrumRaw:" << name << "> binary is good";
 
-  bin_begin_ = file_bin_.tellp();
   open_bin_ = true;
   return true;
 }
@@ -108,7 +141,7 @@ void SpectrumRaw::addEvent(const Event& newEvent) {
 
   std::multiset<Hit> all_hits;
   for (auto &q : newEvent.hits)
-    all_hits.insert(q.second);
+    all_hits.insert(q);
 
   for (auto &q : all_hits)
     writeHit(q);
@@ -127,17 +160,17 @@ void SpectrumRaw::writeHit(const Hit& hit)
 {
   if (open_bin_ && pattern_add_.relevant(hit.source_channel()))
   {
-    hit.write_bin(file_bin_);
+    file_bin_.write(hit);
     hits_this_spill_++;
   }
 }
 
 
 void SpectrumRaw::_push_spill(const Spill& one_spill) {
-  if ((!open_xml_) || (!open_bin_))
+  if ((!open_index_) || (!open_bin_))
     return;
 
-  uint64_t pos = file_bin_.tellp() - bin_begin_;
+  uint64_t pos = file_bin_.position();
 
   Spectrum::_push_spill(one_spill);
 
@@ -148,10 +181,8 @@ void SpectrumRaw::_push_spill(const Spill& one_spill) {
     if (pattern_add_.relevant(s.first))
       stats[s.first] = s.second;
   copy.stats = stats;
-  copy.to_xml(xml_root_, true);
-
-  xml_root_.last_child().append_attribute("raw_hit_count").set_value(std::to_string(hits_this_spill_).c_str());
-  xml_root_.last_child().append_attribute("file_offset").set_value(std::to_string(pos).c_str());
+  index_.append(copy, pos, file_bin_.position() - pos, hits_this_spill_);
+  index_.commit(file_bin_.written());
 
   total_hits_ += hits_this_spill_;
   hits_this_spill_ = 0;
@@ -161,17 +192,18 @@ void SpectrumRaw::_push_spill(const Spill& one_spill) {
 void SpectrumRaw::_flush() {
   Spectrum::_flush();
 
-  if (open_xml_) {
-    DBG << "<SpectrumRaw:" << metadata_.get_attribute("name").value_text << "> writing " << file_name_txt_;
-    if (!xml_doc_.save_file(file_name_txt_.c_str()))
-      ERR << "<SpectrumRaw> Failed to save " << file_name_txt_;
-    open_xml_ = false;
-  }
   if (open_bin_) {
     DBG << "<SpectrumRaw:" << metadata_.get_attribute("name").value_text << "> closing " << file_name_bin_;
     file_bin_.close();
     open_bin_ = false;
   }
+  //footer last, once all hits are on disk
+  if (open_index_) {
+    DBG << "<SpectrumRaw:" << metadata_.get_attribute("name").value_text << "> closing " << file_name_idx_;
+    index_.commit(file_bin_.written());
+    index_.close();
+    open_index_ = false;
+  }
 }
 
 }
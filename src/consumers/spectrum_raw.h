@@ -23,6 +23,8 @@
 #pragma once
 
 #include "spectrum.h"
+#include "list_writer.h"
+#include "list_index.h"
 
 namespace Qpx {
 
@@ -31,14 +33,12 @@ class SpectrumRaw : public Spectrum
 protected:
   std::string file_dir_;
   std::string file_name_bin_;
-  std::string file_name_txt_;
+  std::string file_name_idx_;
 
-  std::ofstream file_bin_;
-  std::streampos bin_begin_;
+  ListWriter file_bin_;
 
-  bool open_xml_, open_bin_;
-  pugi::xml_document xml_doc_;
-  pugi::xml_node xml_root_;
+  bool open_index_, open_bin_;
+  ListIndexWriter index_;
 
   uint64_t hits_this_spill_, total_hits_;
 
@@ -50,10 +50,10 @@ public:
     : Spectrum(other)
     , file_dir_(other.file_dir_)
     , file_name_bin_(other.file_name_bin_)
-    , file_name_txt_(other.file_name_txt_)
+    , file_name_idx_(other.file_name_idx_)
     , hits_this_spill_(0)
     , total_hits_(0)
-    , open_xml_(false)
+    , open_index_(false)
     , open_bin_(false)
   {}
 
@@ -68,17 +68,18 @@ protected:
 
   PreciseFloat _data(std::initializer_list<size_t> list) const override
     { return Consumer::_data(list);}
-  std::unique_ptr<std::list<Entry>> _data_range(std::initializer_list<Pair> range) override
-    { return Consumer::_data_range(range); }
+  bool _readable() const override {return false;}
 
   //event processing
   void _push_spill(const Spill&) override;
   void _push_hit(const Hit&) override;
+  void _push_hits(const HitBatch& hits) override { Consumer::_push_hits(hits); }
+  bool _coincidence_setup(CoincidenceSetup&) const override {return false;}
 
   void addEvent(const Event&) override;
   void _flush() override;
 
-  bool init_text();
+  bool init_index();
   bool init_bin();
   void writeHit(const Hit&);
 
@@ -88,13 +88,13 @@ PreciseFloat TimeSpectrum::_data(std::initializer_list<size_t> list) const {
   if (coords[0] >= spectra_.size())
     return 0;
 
-  if (coords[1] >= spectra_.at(coords[0]).size())
+  if (coords[1] >= spectra_.at(coords[0])->size())
     return 0;
 
-  return spectra_.at(coords[0]).at(coords[1]);
+  return spectra_.at(coords[0])->at(coords[1]);
 }
 
-std::unique_ptr<std::list<Entry>> TimeSpectrum::_data_range(std::initializer_list<Pair> list)
+void TimeSpectrum::_data_columns(std::initializer_list<Pair> list, DataColumns& out) const
 {
   size_t min0, min1, max0, max1;
   if (list.size() != 2)
@@ -113,26 +113,16 @@ std::unique_ptr<std::list<Entry>> TimeSpectrum::_data_range(std::initializer_lis
   if (max1 >= pow(2, bits_))
     max1 = pow(2, bits_);
 
-  std::unique_ptr<std::list<Entry>> result(new std::list<Entry>);
-//  CustomTimer makelist(true);
-
   for (size_t i = min0; i < max0; ++i)
   {
     for (size_t j = min1; j < max1; ++j)
     {
-      PreciseFloat val = spectra_.at(i).at(j);
-      if (to_double(val) == 0)
+      BinCount val = spectra_.at(i)->at(j);
+      if (!val)
         continue;
-      Entry newentry;
-      newentry.first.resize(2, 0);
-      newentry.first[0] = i;
-      newentry.first[1] = j;
-      newentry.second = val;
-      result->push_back(newentry);
+      out.push(i, j, val);
     }
   }
-
-  return result;
 }
 
 void TimeSpectrum::_append(const Entry& e)
@@ -142,24 +132,17 @@ void TimeSpectrum::_append(const Entry& e)
 
 void TimeSpectrum::addHit(const Hit& newHit)
 {
-  uint16_t en = newHit.value(energy_idx_.at(newHit.source_channel())).val(bits_);
+  uint16_t en = energy(newHit);
 //  if (en < cutoff_bin_)
 //    return;
 
-  spectra_[spectra_.size()-1][en]++;
+  current()[en]++;
   total_hits_++;
 
 //  if (en > maxchan_)
 //    maxchan_ = en;
 }
 
-void TimeSpectrum::addEvent(const Event& newEvent)
-{
-  for (auto &h : newEvent.hits)
-    if (pattern_add_.relevant(h.first))
-      this->addHit(h.second);
-}
-
 void TimeSpectrum::_push_stats(const StatsUpdate& newStats)
 {
   if (pattern_add_.relevant(newStats.source_channel))
@@ -169,7 +152,7 @@ void TimeSpectrum::_push_stats(const StatsUpdate& newStats)
     PreciseFloat percent_dead = 0;
     PreciseFloat tot_time = 0;
 
-    spectra_.push_back(std::vector<PreciseFloat>(pow(2, bits_)));
+    spectra_.push_back(std::make_shared<std::vector<BinCount>>(pow(2, bits_)));
 
     if (!updates_.empty())
     {
@@ -185,12 +168,12 @@ void TimeSpectrum::_push_stats(const StatsUpdate& newStats)
 
       StatsUpdate diff = newStats - updates_.back();
       PreciseFloat scale_factor = 1;
-      if (diff.items.count("native_time") && (diff.items.at("native_time") > 0))
-        scale_factor = rt.total_microseconds() / diff.items["native_time"];
+      if (diff.items.count(StatsKey::native_time) && (diff.items.at(StatsKey::native_time) > 0))
+        scale_factor = rt.total_microseconds() / diff.items[StatsKey::native_time];
 
-      if (diff.items.count("live_time"))
+      if (diff.items.count(StatsKey::live_time))
       {
-        PreciseFloat scaled_live = diff.items.at("live_time") * scale_factor;
+        PreciseFloat scaled_live = diff.items.at(StatsKey::live_time) * scale_factor;
         lt = boost::posix_time::microseconds(static_cast<long>(to_double(scaled_live)));
       }
 
@@ -246,16 +229,16 @@ void TimeSpectrum::_save_data(H5CC::Group& g) const
 
   hsize_t spsize = H5CC::kMax;
   if (spectra_.size())
-    spsize = spectra_[0].size();
+    spsize = spectra_[0]->size();
 
   auto dsdata = dgroup.require_dataset<long double>("spectra",
                                                     {spsize, spectra_.size()},
                                                     {128,1});
   for (size_t i = 0; i < spectra_.size(); ++i)
   {
-    std::vector<long double> spectrum(spectra_[i].size());
+    std::vector<long double> spectrum(spectra_[i]->size());
     for (size_t j = 0; j < spectrum.size(); ++j)
-      spectrum[j] = static_cast<long double>(spectra_[i][j]);
+      spectrum[j] = static_cast<long double>((*spectra_[i])[j]);
     dsdata.write(spectrum, {spectrum.size(), 1}, {0,i});
   }
 
@@ -290,9 +273,9 @@ void TimeSpectrum::_load_data(H5CC::Group &g)
   {
     std::vector<long double> spectrum(size);
     dspec.read(spectrum, {size, 1}, {0,i});
-    spectra_[i].resize(spectrum.size());
+    spectra_[i] = std::make_shared<std::vector<BinCount>>(spectrum.size());
     for (size_t j = 0; j < spectrum.size(); ++j)
-      spectra_[i][j] = spectrum[j];
+      (*spectra_[i])[j] = static_cast<BinCount>(spectrum[j]);
   }
 
   //updates?
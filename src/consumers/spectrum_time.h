@@ -23,6 +23,8 @@
 #pragma once
 
 #include "spectrum.h"
+#include <atomic>
+#include <memory>
 
 namespace Qpx {
 
@@ -30,21 +32,56 @@ class TimeSpectrum : public Spectrum
 {
 public:
   TimeSpectrum();
+  //history false leaves out stats that only ingest needs, for snapshots
+  TimeSpectrum(const TimeSpectrum& other, bool history = true)
+    : Spectrum(other)
+    , spectra_(other.spectra_)
+    , seconds_(other.seconds_)
+  {
+    if (history)
+      updates_ = other.updates_;
+  }
   TimeSpectrum* clone() const override { return new TimeSpectrum(*this); }
   
 protected:
   std::string my_type() const override {return "TimeSpectrum";}
 
   bool _initialize() override;
+  Consumer* _snapshot_copy() const override { return new TimeSpectrum(*this, false); }
 
   PreciseFloat _data(std::initializer_list<size_t> list) const override;
-  std::unique_ptr<std::list<Entry>> _data_range(std::initializer_list<Pair> list) override;
+  void _data_columns(std::initializer_list<Pair> list, DataColumns& out) const override;
   void _append(const Entry&) override;
   void _set_detectors(const std::vector<Qpx::Detector>& dets) override;
 
   //event processing
-  void addEvent(const Event&) override;
+  void _add_events(Span<Event> events) override
+  { fill_events(events, [this](const Event& e) { fill_event(e); }); }
+  void addEvent(const Event& e) override { fill_event(e); }
   virtual void addHit(const Hit&);
+
+  inline void fill_event(const Event& newEvent)
+  {
+    std::vector<BinCount>& spectrum = current();
+    for (auto &h : newEvent.hits)
+      if (pattern_add_.relevant(h.source_channel()))
+      {
+        spectrum[energy(h)]++;
+        total_hits_++;
+      }
+  }
+
+  //last spectrum, the only one still filled; copied first if a
+  //snapshot shares it
+  inline std::vector<BinCount>& current()
+  {
+    std::shared_ptr<std::vector<BinCount>>& last = spectra_.back();
+    if (last.use_count() > 1)
+      last = std::make_shared<std::vector<BinCount>>(*last);
+    else
+      std::atomic_thread_fence(std::memory_order_acquire);
+    return *last;
+  }
   void _push_stats(const StatsUpdate&) override;
 
   std::string _data_to_xml() const override;
@@ -55,7 +92,8 @@ protected:
   void _save_data(H5CC::Group&) const override;
   #endif
 
-  std::vector<std::vector<PreciseFloat>> spectra_;
+  //one per stats update; snapshots share them
+  std::vector<std::shared_ptr<std::vector<BinCount>>> spectra_;
 //  std::vector<PreciseFloat> counts_;
   std::vector<PreciseFloat> seconds_;
   std::vector<StatsUpdate>  updates_;
@@ -105,7 +105,7 @@ PreciseFloat TimeDomain::_data(std::initializer_list<size_t> list) const {
     return spectrum_[chan];
 }
 
-std::unique_ptr<std::list<Entry>> TimeDomain::_data_range(std::initializer_list<Pair> list) {
+void TimeDomain::_data_columns(std::initializer_list<Pair> list, DataColumns& out) const {
   size_t min, max;
   if (list.size() != 1) {
     min = 0;
@@ -116,20 +116,16 @@ std::unique_ptr<std::list<Entry>> TimeDomain::_data_range(std::initializer_list<
     max = range.second;
   }
 
+  if (spectrum_.empty())
+    return;
   if (max >= spectrum_.size())
     max = spectrum_.size() - 1;
+  if (min > max)
+    return;
 
-  //in range?
-  
-  std::unique_ptr<std::list<Entry>> result(new std::list<Entry>);
-  for (size_t i=min; i <= max; i++) {
-    Entry newentry;
-    newentry.first.resize(1, 0);
-    newentry.first[0] = i;
-    newentry.second = spectrum_[i];
-    result->push_back(newentry);
-  }
-  return result;
+  out.reserve(max - min + 1);
+  for (size_t i=min; i <= max; i++)
+    out.push(i, spectrum_[i]);
 }
 
 void TimeDomain::_append(const Entry& e) {
@@ -166,11 +162,11 @@ void TimeDomain::_push_stats(const StatsUpdate& newStats)
 
       StatsUpdate diff = newStats - updates_.back();
       PreciseFloat scale_factor = 1;
-      if (diff.items.count("native_time") && (diff.items.at("native_time") > 0))
-        scale_factor = rt.total_microseconds() / diff.items["native_time"];
+      if (diff.items.count(StatsKey::native_time) && (diff.items.at(StatsKey::native_time) > 0))
+        scale_factor = rt.total_microseconds() / diff.items[StatsKey::native_time];
 
-      if (diff.items.count("live_time")) {
-        PreciseFloat scaled_live = diff.items.at("live_time") * scale_factor;
+      if (diff.items.count(StatsKey::live_time)) {
+        PreciseFloat scaled_live = diff.items.at(StatsKey::live_time) * scale_factor;
         lt = boost::posix_time::microseconds(static_cast<long>(to_double(scaled_live)));
       }
 
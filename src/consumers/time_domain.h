@@ -30,15 +30,28 @@ class TimeDomain : public Spectrum
 {
 public:
   TimeDomain();
+  //history false leaves out what only ingest needs, for snapshots
+  TimeDomain(const TimeDomain& other, bool history = true)
+    : Spectrum(other)
+    , codomain(other.codomain)
+    , spectrum_(other.spectrum_)
+    , seconds_(other.seconds_)
+  {
+    if (history) {
+      counts_ = other.counts_;
+      updates_ = other.updates_;
+    }
+  }
   TimeDomain* clone() const override { return new TimeDomain(*this); }
   
 protected:
   std::string my_type() const override {return "Time";}
 
   bool _initialize() override;
+  Consumer* _snapshot_copy() const override { return new TimeDomain(*this, false); }
 
   PreciseFloat _data(std::initializer_list<size_t> list) const override;
-  std::unique_ptr<std::list<Entry>> _data_range(std::initializer_list<Pair> list) override;
+  void _data_columns(std::initializer_list<Pair> list, DataColumns& out) const override;
   void _append(const Entry&) override;
   void _set_detectors(const std::vector<Qpx::Detector>& dets) override;
 
@@ -0,0 +1,110 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::BuildDiagnostics  rate-limited anomaly reporting
+ *
+ ******************************************************************************/
+
+#include "build_diagnostics.h"
+#include "custom_logger.h"
+
+namespace Qpx {
+
+BuildCounts& BuildCounts::operator+=(const BuildCounts& other)
+{
+  multiple   += other.multiple;
+  pileup     += other.pileup;
+  antecedent += other.antecedent;
+  return *this;
+}
+
+BuildDiagnostics::BuildDiagnostics()
+{
+  for (size_t i=0; i < 3; ++i)
+    totals_[i].store(0);
+  restart();
+}
+
+BuildDiagnostics::BuildDiagnostics(const BuildDiagnostics& other)
+{
+  for (size_t i=0; i < 3; ++i)
+    totals_[i].store(other.totals_[i].load());
+  restart();
+}
+
+BuildDiagnostics& BuildDiagnostics::operator=(const BuildDiagnostics& other)
+{
+  if (this == &other)
+    return *this;
+  for (size_t i=0; i < 3; ++i)
+    totals_[i].store(other.totals_[i].load());
+  restart();
+  return *this;
+}
+
+void BuildDiagnostics::restart()
+{
+  for (size_t i=0; i < 3; ++i)
+    interval_[i] = 0;
+  exemplars_.clear();
+  interval_start_ = boost::posix_time::microsec_clock::universal_time();
+}
+
+BuildCounts BuildDiagnostics::counts() const
+{
+  BuildCounts ret;
+  ret.multiple   = totals_[0].load(std::memory_order_relaxed);
+  ret.pileup     = totals_[1].load(std::memory_order_relaxed);
+  ret.antecedent = totals_[2].load(std::memory_order_relaxed);
+  return ret;
+}
+
+void BuildDiagnostics::sample(Anomaly a, const Hit& hit)
+{
+  switch (a) {
+  case Anomaly::multiple:
+    exemplars_.push_back("multiple " + hit.to_string());
+    break;
+  case Anomaly::pileup:
+    exemplars_.push_back("pileup " + hit.to_string());
+    break;
+  case Anomaly::antecedent:
+    exemplars_.push_back("antecedent " + hit.to_string());
+    break;
+  }
+}
+
+bool BuildDiagnostics::due() const
+{
+  return ((boost::posix_time::microsec_clock::universal_time() - interval_start_)
+          >= boost::posix_time::seconds(long(kReportSeconds)));
+}
+
+void BuildDiagnostics::report(const std::string& who)
+{
+  if (interval_[0] || interval_[1] || interval_[2])
+  {
+    double secs = (boost::posix_time::microsec_clock::universal_time()
+                   - interval_start_).total_milliseconds() * 0.001;
+    DBG << "<EventBuilder> " << who << " in last " << secs << "s: "
+        << interval_[0] << " hits coincident with more than one other hit, "
+        << interval_[1] << " pileup hits, "
+        << interval_[2] << " antecedent hits";
+    for (auto &e : exemplars_)
+      DBG << "<EventBuilder>   e.g. " << e;
+  }
+  restart();
+}
+
+}
@@ -0,0 +1,80 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::BuildCounts       totals of anomalous hits seen by a builder
+ *
+ *      Qpx::BuildDiagnostics  counts anomalies during event building and
+ *                             keeps the first few of each interval as
+ *                             examples; a summary is logged at most once
+ *                             per interval instead of one line per hit.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "hit.h"
+#include <atomic>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+namespace Qpx {
+
+struct BuildCounts
+{
+  uint64_t multiple {0};    //hit joined more than one event
+  uint64_t pileup {0};      //channel already present in coincident event
+  uint64_t antecedent {0};  //hit precedes an open event
+
+  BuildCounts& operator+=(const BuildCounts& other);
+};
+
+class BuildDiagnostics
+{
+public:
+  enum class Anomaly : uint8_t { multiple = 0, pileup = 1, antecedent = 2 };
+
+  static const size_t   kExemplars = 3;       //examples kept per interval
+  static const uint32_t kReportSeconds = 10;  //minimum between summaries
+
+  BuildDiagnostics();
+  BuildDiagnostics(const BuildDiagnostics& other);
+  BuildDiagnostics& operator=(const BuildDiagnostics& other);
+
+  inline void record(Anomaly a, const Hit& hit)
+  {
+    size_t i = static_cast<size_t>(a);
+    totals_[i].fetch_add(1, std::memory_order_relaxed);
+    if (interval_[i]++ < kExemplars)
+      sample(a, hit);
+  }
+
+  //safe to call from any thread
+  BuildCounts counts() const;
+
+  //true once the interval has elapsed
+  bool due() const;
+
+  //logs and restarts the interval; silent if nothing happened
+  void report(const std::string& who);
+
+private:
+  std::atomic<uint64_t> totals_[3];
+  uint64_t interval_[3];
+  std::vector<std::string> exemplars_;
+  boost::posix_time::ptime interval_start_;
+
+  void sample(Anomaly a, const Hit& hit);
+  void restart();
+};
+
+}
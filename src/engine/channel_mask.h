@@ -0,0 +1,133 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::ChannelMask   fixed 128-bit set of channels, for event
+ *                         occupancy and compiled coincidence patterns
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace Qpx {
+
+class ChannelMask
+{
+public:
+  static const int16_t kChannels = 128;
+
+  inline ChannelMask() {}
+
+  static inline bool in_range(int32_t chan)
+  {
+    return ((chan >= 0) && (chan < kChannels));
+  }
+
+  inline bool test(int32_t chan) const
+  {
+    return in_range(chan) && ((words_[chan >> 6] >> (chan & 63)) & 1);
+  }
+
+  inline void set(int32_t chan)
+  {
+    if (in_range(chan))
+      words_[chan >> 6] |= (uint64_t(1) << (chan & 63));
+  }
+
+  inline void reset(int32_t chan)
+  {
+    if (in_range(chan))
+      words_[chan >> 6] &= ~(uint64_t(1) << (chan & 63));
+  }
+
+  inline void clear()
+  {
+    words_[0] = words_[1] = 0;
+  }
+
+  inline bool none() const { return !(words_[0] | words_[1]); }
+  inline bool any() const { return !none(); }
+
+  inline size_t count() const
+  {
+    return popcount(words_[0]) + popcount(words_[1]);
+  }
+
+  //number of channels set below chan
+  inline size_t rank(int32_t chan) const
+  {
+    if (chan <= 0)
+      return 0;
+    if (chan >= kChannels)
+      return count();
+    uint64_t below = (uint64_t(1) << (chan & 63)) - 1;
+    if (chan < 64)
+      return popcount(words_[0] & below);
+    return popcount(words_[0]) + popcount(words_[1] & below);
+  }
+
+  inline ChannelMask operator&(const ChannelMask& other) const
+  {
+    ChannelMask ret;
+    ret.words_[0] = words_[0] & other.words_[0];
+    ret.words_[1] = words_[1] & other.words_[1];
+    return ret;
+  }
+
+  inline ChannelMask operator|(const ChannelMask& other) const
+  {
+    ChannelMask ret;
+    ret.words_[0] = words_[0] | other.words_[0];
+    ret.words_[1] = words_[1] | other.words_[1];
+    return ret;
+  }
+
+  //this AND NOT other
+  inline ChannelMask andnot(const ChannelMask& other) const
+  {
+    ChannelMask ret;
+    ret.words_[0] = words_[0] & ~other.words_[0];
+    ret.words_[1] = words_[1] & ~other.words_[1];
+    return ret;
+  }
+
+  inline bool operator==(const ChannelMask& other) const
+  {
+    return (words_[0] == other.words_[0]) && (words_[1] == other.words_[1]);
+  }
+
+  inline bool operator!=(const ChannelMask& other) const
+  {
+    return !operator==(other);
+  }
+
+private:
+  uint64_t words_[2] {0, 0};
+
+  static inline size_t popcount(uint64_t w)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(w);
+#else
+    size_t c = 0;
+    for (; w; ++c)
+      w &= w - 1;
+    return c;
+#endif
+  }
+};
+
+}
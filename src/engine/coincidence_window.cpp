@@ -0,0 +1,149 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::CoincidenceWindow  open events on a common integer timeline
+ *
+ ******************************************************************************/
+
+#include "coincidence_window.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Qpx {
+
+static inline uint64_t gcd64(uint64_t a, uint64_t b)
+{
+  while (b)
+  {
+    uint64_t t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+CoincidenceWindow::CoincidenceWindow(double window_ns, double max_delay_ns)
+  : window_ns_(std::max(window_ns, 0.0))
+  , max_delay_ns_(std::max(window_ns_, max_delay_ns))
+{}
+
+void CoincidenceWindow::add_timebase(const TimeStamp& base)
+{
+  TimeStamp common = base.make(0);
+  if (timeline_set_)
+  {
+    common = TimeStamp::common_timebase(timeline_, common);
+    if (common.same_base(timeline_))
+      return;
+  }
+  timeline_ = common.make(0);
+  timeline_set_ = true;
+  rebuild();
+}
+
+void CoincidenceWindow::rebuild()
+{
+  double mult = timeline_.timebase_multiplier();
+  double div  = timeline_.timebase_divider();
+  window_ticks_    = std::floor(window_ns_ * div / mult);
+  max_delay_ticks_ = std::floor(max_delay_ns_ * div / mult);
+
+  scales_.clear();
+  last_scale_ = 0;
+
+  //conversion is monotonic, order is kept
+  for (auto &o : open_)
+    o.start = ticks(o.event.lower_time);
+}
+
+const CoincidenceWindow::Scale& CoincidenceWindow::scale_for(const TimeStamp& t)
+{
+  uint32_t mult = t.timebase_multiplier();
+  uint32_t div  = t.timebase_divider();
+
+  if ((last_scale_ < scales_.size())
+      && (scales_[last_scale_].multiplier == mult)
+      && (scales_[last_scale_].divider == div))
+    return scales_[last_scale_];
+
+  for (size_t i=0; i < scales_.size(); ++i)
+    if ((scales_[i].multiplier == mult) && (scales_[i].divider == div))
+      return scales_[last_scale_ = i];
+
+  if (!timeline_set_ ||
+      !TimeStamp::common_timebase(timeline_, t).same_base(timeline_))
+    add_timebase(t);
+
+  Scale s;
+  s.multiplier = mult;
+  s.divider = div;
+  s.num = uint64_t(mult) * uint64_t(timeline_.timebase_divider());
+  s.den = uint64_t(div) * uint64_t(timeline_.timebase_multiplier());
+  uint64_t g = gcd64(s.num, s.den);
+  s.num /= g;
+  s.den /= g;
+  scales_.push_back(s);
+  last_scale_ = scales_.size() - 1;
+  return scales_.back();
+}
+
+int64_t CoincidenceWindow::ticks(const TimeStamp& t)
+{
+  const Scale& s = scale_for(t);
+  uint64_t native = t.native();
+  if ((s.num == 1) && (s.den == 1))
+    return native;
+  if (native <= (UINT64_MAX / s.num))
+    return (native * s.num) / s.den;
+  return static_cast<int64_t>(static_cast<long double>(native) * s.num / s.den);
+}
+
+CoincidenceWindow::Placement CoincidenceWindow::push(const Hit& hit, EventBatch& finished)
+{
+  Placement ret;
+  int64_t t = ticks(hit.timestamp());
+
+  auto before = [](const OpenEvent& o, int64_t v) { return (o.start < v); };
+  auto after  = [](int64_t v, const OpenEvent& o) { return (v < o.start); };
+
+  //candidates started within one window before the hit
+  auto it = std::lower_bound(open_.begin(), open_.end(), t - window_ticks_, before);
+  for (; (it != open_.end()) && (it->start <= t); ++it)
+  {
+    if (it->event.addHit(hit))
+      ret.appended++;
+    else
+      ret.pileup = true;
+  }
+  ret.antecedent = (it != open_.end());
+
+  if (!ret.appended && !ret.pileup)
+  {
+    OpenEvent o {t, Event(hit, window_ns_, max_delay_ns_)};
+    if (open_.empty() || (open_.back().start <= t))
+      open_.push_back(std::move(o));
+    else
+      open_.insert(std::upper_bound(open_.begin(), open_.end(), t, after), std::move(o));
+  }
+
+  while (!open_.empty() && ((t - open_.front().start) > max_delay_ticks_))
+  {
+    finished.push_back(std::move(open_.front().event));
+    open_.pop_front();
+  }
+
+  return ret;
+}
+
+}
@@ -0,0 +1,87 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::CoincidenceWindow  open events indexed by start time on an
+ *                              integer timeline common to all channels.
+ *                              Each hit is converted once; candidate
+ *                              events are found by binary search rather
+ *                              than by scanning the whole backlog.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "event.h"
+#include <deque>
+
+namespace Qpx {
+
+class CoincidenceWindow
+{
+public:
+  struct Placement
+  {
+    uint16_t appended {0};  //events the hit joined
+    bool pileup {false};    //channel already taken in a coincident event
+    bool antecedent {false};//hit precedes an open event
+  };
+
+  CoincidenceWindow() {}
+  CoincidenceWindow(double window_ns, double max_delay_ns);
+
+  //fold a channel timebase into the common timeline, e.g. at run start
+  void add_timebase(const TimeStamp& base);
+  const TimeStamp& timeline() const { return timeline_; }
+
+  //hit in common ticks; unseen timebases are folded in
+  int64_t ticks(const TimeStamp& t);
+
+  //joins or opens events; events no longer reachable move to finished
+  Placement push(const Hit& hit, EventBatch& finished);
+
+  size_t open_events() const { return open_.size(); }
+
+private:
+  struct OpenEvent
+  {
+    int64_t start;
+    Event   event;
+  };
+
+  //native -> common: ticks = native * num / den
+  struct Scale
+  {
+    uint32_t multiplier, divider;
+    uint64_t num, den;
+  };
+
+  double window_ns_ {0};
+  double max_delay_ns_ {0};
+
+  TimeStamp timeline_;
+  bool      timeline_set_ {false};
+  int64_t   window_ticks_ {0};
+  int64_t   max_delay_ticks_ {0};
+
+  std::vector<Scale> scales_;
+  size_t last_scale_ {0};
+
+  //ordered by start; appended at the back in the common case
+  std::deque<OpenEvent> open_;
+
+  const Scale& scale_for(const TimeStamp& t);
+  void rebuild();
+};
+
+}
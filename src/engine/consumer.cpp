@@ -90,21 +90,83 @@ bool Consumer::_initialize() {
 }
 
 
+uint64_t Consumer::version() const {
+  return version_.load();
+}
+
 PreciseFloat Consumer::data(std::initializer_list<size_t> list ) const {
-  boost::shared_lock<boost::shared_mutex> lock(shared_mutex_);
-  if (list.size() != this->metadata_.dimensions())
+  std::shared_ptr<const Consumer> snap = snapshot();
+  if (!snap || (list.size() != snap->metadata_.dimensions()))
     return 0;
-  return this->_data(list);
+  return snap->_data(list);
+}
+
+void Consumer::data_columns(std::initializer_list<Pair> list, DataColumns& out) const {
+  std::shared_ptr<const Consumer> snap = snapshot();
+  if (!snap) {
+    out.clear(metadata().dimensions());
+    return;
+  }
+  out.clear(snap->metadata_.dimensions());
+  if (list.size() != out.dimensions)
+    return;
+  snap->_data_columns(list, out);
+}
+
+void Consumer::data_delta(std::initializer_list<Pair> list, uint32_t& since, DataColumns& out) const {
+  std::shared_ptr<const Consumer> snap = snapshot();
+  if (!snap) {
+    out.clear(metadata().dimensions());
+    return;
+  }
+  out.clear(snap->metadata_.dimensions());
+  if (list.size() != out.dimensions)
+    return;
+  snap->_data_delta(list, since, out);
+}
+
+void Consumer::data_slab(std::initializer_list<Pair> list, std::vector<PreciseFloat>& out) const {
+  out.clear();
+  std::vector<Pair> ranges(list.begin(), list.end());
+  size_t total = ranges.empty() ? 0 : 1;
+  for (auto &r : ranges) {
+    if (r.second < r.first)
+      return;
+    total *= (r.second - r.first + 1);
+  }
+  out.assign(total, 0);
+
+  DataColumns columns;
+  data_columns(list, columns);
+  for (size_t i = 0; i < columns.size(); ++i) {
+    size_t idx = 0;
+    bool inside = true;
+    for (size_t d = 0; d < ranges.size(); ++d) {
+      size_t c = columns.coord(i, d);
+      if ((c < ranges[d].first) || (c > ranges[d].second)) {
+        inside = false;
+        break;
+      }
+      idx = idx * (ranges[d].second - ranges[d].first + 1) + (c - ranges[d].first);
+    }
+    if (inside)
+      out[idx] = columns.counts[i];
+  }
 }
 
 std::unique_ptr<std::list<Entry>> Consumer::data_range(std::initializer_list<Pair> list) {
-  boost::shared_lock<boost::shared_mutex> lock(shared_mutex_);
-  if (list.size() != this->metadata_.dimensions())
+  DataColumns columns;
+  data_columns(list, columns);
+  if (list.size() != columns.dimensions)
     return 0; //wtf???
-  else {
-    //    std::vector<Pair> ranges(list.begin(), list.end());
-    return this->_data_range(list);
+
+  std::unique_ptr<std::list<Entry>> result(new std::list<Entry>);
+  for (size_t i = 0; i < columns.size(); ++i) {
+    auto begin = columns.coords.begin() + i * columns.dimensions;
+    result->push_back(Entry(std::vector<size_t>(begin, begin + columns.dimensions),
+                            columns.counts[i]));
   }
+  return result;
 }
 
 void Consumer::append(const Entry& e) {
@@ -113,16 +175,71 @@ void Consumer::append(const Entry& e) {
     return;
   else
     this->_append(e);
+  version_++;
+}
+
+std::shared_ptr<const Consumer> Consumer::snapshot() const {
+  if (!this->_readable())
+    return nullptr;
+
+  boost::unique_lock<boost::mutex> lock(snapshot_mutex_);
+  uint64_t wanted = version_.load();
+  if (snapshot_ && (snapshot_version_ == wanted))
+    return snapshot_;
+
+  if (live_.load()) {
+    //during acquisition a recent view is good enough
+    if (snapshot_ &&
+        ((boost::posix_time::microsec_clock::universal_time() - snapshot_time_)
+         < boost::posix_time::milliseconds(250)))
+      return snapshot_;
+
+    //ingest thread publishes after its next spill
+    snapshot_requested_.store(true);
+    if (snapshot_cond_.wait_for(lock, boost::chrono::seconds(2),
+                                [this, wanted]{ return (snapshot_version_ >= wanted); }))
+      return snapshot_;
+
+    //ingest stalled; stale data beats blocking it
+    if (snapshot_)
+      return snapshot_;
+  }
+
+  //no acquisition in progress, copy directly
+  lock.unlock();
+  boost::unique_lock<boost::mutex> uniqueLock(unique_mutex_);
+  publish_snapshot();
+  lock.lock();
+  return snapshot_;
+}
+
+void Consumer::publish_snapshot() const {
+  std::shared_ptr<const Consumer> fresh(this->_snapshot_copy());
+  boost::unique_lock<boost::mutex> lock(snapshot_mutex_);
+  snapshot_ = fresh;
+  snapshot_version_ = version_.load();
+  snapshot_time_ = boost::posix_time::microsec_clock::universal_time();
+  snapshot_requested_.store(false);
+  snapshot_cond_.notify_all();
+  lock.unlock();
+  this->_snapshot_taken();
+}
+
+void Consumer::changed_data() {
+  version_++;
+  if (!snapshot_requested_.load() || !this->_readable())
+    return;
+  publish_snapshot();
 }
 
 bool Consumer::from_prototype(const ConsumerMetadata& newtemplate) {
-  boost::unique_lock<boost::mutex> uniqueLock(unique_mutex_, boost::defer_lock);
-  while (!uniqueLock.try_lock())
-    boost::this_thread::sleep_for(boost::chrono::seconds{1});
+  boost::unique_lock<boost::mutex> uniqueLock(unique_mutex_);
 
   if (metadata_.type() != newtemplate.type())
     return false;
 
+  version_++;
+  live_.store(false);
   metadata_.overwrite_all_attributes(newtemplate.attributes());
   metadata_.detectors.clear(); // really?
 
@@ -132,10 +249,10 @@ bool Consumer::from_prototype(const ConsumerMetadata& newtemplate) {
 }
 
 void Consumer::push_spill(const Spill& one_spill) {
-  boost::unique_lock<boost::mutex> uniqueLock(unique_mutex_, boost::defer_lock);
-  while (!uniqueLock.try_lock())
-    boost::this_thread::sleep_for(boost::chrono::seconds{1});
+  boost::unique_lock<boost::mutex> uniqueLock(unique_mutex_);
+  live_.store(true);
   this->_push_spill(one_spill);
+  changed_data();
 }
 
 void Consumer::_push_spill(const Spill& one_spill) {
@@ -144,8 +261,7 @@ void Consumer::_push_spill(const Spill& one_spill) {
   if (!one_spill.detectors.empty())
     this->_set_detectors(one_spill.detectors);
 
-  for (auto &q : one_spill.hits)
-    this->_push_hit(q);
+  this->_push_hits(one_spill.hits);
 
   for (auto &q : one_spill.stats)
     this->_push_stats(q.second);
@@ -157,11 +273,40 @@ void Consumer::_push_spill(const Spill& one_spill) {
   //  DBG << "<" << metadata_.name << "> left in backlog " << backlog.size();
 }
 
+void Consumer::_push_hits(const HitBatch& hits) {
+  for (const auto &q : hits)
+    this->_push_hit(q);
+}
+
+void Consumer::push_events(const Spill& one_spill, const EventBatch& events,
+                           const BuildCounts& counts) {
+  boost::unique_lock<boost::mutex> uniqueLock(unique_mutex_);
+  live_.store(true);
+  this->_set_build_counts(counts);
+  this->_push_events(one_spill, events);
+  changed_data();
+}
+
+void Consumer::_push_events(const Spill& one_spill, const EventBatch& events) {
+  if (!one_spill.detectors.empty())
+    this->_set_detectors(one_spill.detectors);
+
+  this->_add_events(Span<Event>(events));
+
+  for (auto &q : one_spill.stats)
+    this->_push_stats(q.second);
+}
+
+bool Consumer::coincidence_setup(CoincidenceSetup& setup) const {
+  boost::shared_lock<boost::shared_mutex> lock(shared_mutex_);
+  return this->_coincidence_setup(setup);
+}
+
 void Consumer::flush() {
-  boost::unique_lock<boost::mutex> uniqueLock(unique_mutex_, boost::defer_lock);
-  while (!uniqueLock.try_lock())
-    boost::this_thread::sleep_for(boost::chrono::seconds{1});
+  boost::unique_lock<boost::mutex> uniqueLock(unique_mutex_);
   this->_flush();
+  live_.store(false);
+  changed_data();
 }
 
 
@@ -182,18 +327,15 @@ bool Consumer::changed() const
 }
 
 void Consumer::set_detectors(const std::vector<Qpx::Detector>& dets) {
-  boost::unique_lock<boost::mutex> uniqueLock(unique_mutex_, boost::defer_lock);
-  while (!uniqueLock.try_lock())
-    boost::this_thread::sleep_for(boost::chrono::seconds{1});
+  boost::unique_lock<boost::mutex> uniqueLock(unique_mutex_);
   
   this->_set_detectors(dets);
   changed_ = true;
+  version_++;
 }
 
 void Consumer::reset_changed() {
-  boost::unique_lock<boost::mutex> uniqueLock(unique_mutex_, boost::defer_lock);
-  while (!uniqueLock.try_lock())
-    boost::this_thread::sleep_for(boost::chrono::seconds{1});
+  boost::unique_lock<boost::mutex> uniqueLock(unique_mutex_);
   changed_ = false;
 }
 
@@ -203,9 +345,8 @@ bool Consumer::write_file(std::string dir, std::string format) const {
 }
 
 bool Consumer::read_file(std::string name, std::string format) {
-  boost::unique_lock<boost::mutex> uniqueLock(unique_mutex_, boost::defer_lock);
-  while (!uniqueLock.try_lock())
-    boost::this_thread::sleep_for(boost::chrono::seconds{1});
+  boost::unique_lock<boost::mutex> uniqueLock(unique_mutex_);
+  version_++;
   return _read_file(name, format);
 }
 
@@ -257,19 +398,17 @@ std::string Consumer::debug() const
 //change stuff
 
 void Consumer::set_attribute(const Setting &setting) {
-  boost::unique_lock<boost::mutex> uniqueLock(unique_mutex_, boost::defer_lock);
-  while (!uniqueLock.try_lock())
-    boost::this_thread::sleep_for(boost::chrono::seconds{1});
+  boost::unique_lock<boost::mutex> uniqueLock(unique_mutex_);
   metadata_.set_attribute(setting);
   changed_ = true;
+  version_++;
 }
 
 void Consumer::set_attributes(const Setting &settings) {
-  boost::unique_lock<boost::mutex> uniqueLock(unique_mutex_, boost::defer_lock);
-  while (!uniqueLock.try_lock())
-    boost::this_thread::sleep_for(boost::chrono::seconds{1});
+  boost::unique_lock<boost::mutex> uniqueLock(unique_mutex_);
   metadata_.set_attributes(settings);
   changed_ = true;
+  version_++;
 }
 
 
@@ -295,9 +434,9 @@ void Consumer::save(pugi::xml_node &root) const {
 
 bool Consumer::load(const pugi::xml_node &node) {
 
-  boost::unique_lock<boost::mutex> uniqueLock(unique_mutex_, boost::defer_lock);
-  while (!uniqueLock.try_lock())
-    boost::this_thread::sleep_for(boost::chrono::seconds{1});
+  boost::unique_lock<boost::mutex> uniqueLock(unique_mutex_);
+  version_++;
+  live_.store(false);
 
   if (node.child(metadata_.xml_element_name().c_str()))
     metadata_.from_xml(node.child(metadata_.xml_element_name().c_str()));
@@ -322,9 +461,9 @@ bool Consumer::load(const pugi::xml_node &node) {
 #ifdef H5_ENABLED
 bool Consumer::load(H5CC::Group& g, bool withdata)
 {
-  boost::unique_lock<boost::mutex> uniqueLock(unique_mutex_, boost::defer_lock);
-  while (!uniqueLock.try_lock())
-    boost::this_thread::sleep_for(boost::chrono::seconds{1});
+  boost::unique_lock<boost::mutex> uniqueLock(unique_mutex_);
+  version_++;
+  live_.store(false);
 
   if (!g.has_group("metadata"))
     return false;
@@ -18,6 +18,9 @@
  * Description:
  *      Qpx::Consumer generic spectrum type.
  *                       All public methods are thread-safe.
+ *                       Data is read from a versioned snapshot that
+ *                       the ingest thread publishes on demand, so
+ *                       readers never stall acquisition.
  *                       When deriving override protected methods.
  *
  *      Qpx::ConsumerFactory creates spectra of appropriate type
@@ -32,8 +35,11 @@
 
 #include "consumer_metadata.h"
 #include "spill.h"
+#include "event_builder.h"
 #include <initializer_list>
 #include <boost/thread.hpp>
+#include <boost/atomic.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 
 #include "json.hpp"
 using namespace nlohmann;
@@ -48,6 +54,44 @@ typedef std::pair<std::vector<size_t>, PreciseFloat> Entry;
 typedef std::list<Entry> EntryList;
 typedef std::pair<size_t, size_t> Pair;
 
+//bulk data in flat arrays; point i is at coords[i*dimensions + d]
+//clear() keeps capacity, so a reused instance does not allocate
+struct DataColumns
+{
+  uint16_t dimensions {0};
+  std::vector<size_t> coords;
+  std::vector<PreciseFloat> counts;
+
+  inline size_t size() const { return counts.size(); }
+  inline size_t coord(size_t i, uint16_t d) const { return coords[i * dimensions + d]; }
+
+  inline void clear(uint16_t dims)
+  {
+    dimensions = dims;
+    coords.clear();
+    counts.clear();
+  }
+
+  inline void reserve(size_t n)
+  {
+    coords.reserve(n * dimensions);
+    counts.reserve(n);
+  }
+
+  inline void push(size_t x, PreciseFloat count)
+  {
+    coords.push_back(x);
+    counts.push_back(count);
+  }
+
+  inline void push(size_t x, size_t y, PreciseFloat count)
+  {
+    coords.push_back(x);
+    coords.push_back(y);
+    counts.push_back(count);
+  }
+};
+
 
 class Consumer
 {
@@ -59,11 +103,22 @@ protected:
   mutable boost::mutex unique_mutex_;
   bool changed_;
 
+  //read-only copy for readers, see snapshot()
+  mutable boost::mutex snapshot_mutex_;
+  mutable boost::condition_variable snapshot_cond_;
+  mutable std::shared_ptr<const Consumer> snapshot_;
+  mutable uint64_t snapshot_version_ {0};
+  mutable boost::posix_time::ptime snapshot_time_;
+  mutable boost::atomic<bool> snapshot_requested_ {false};
+  boost::atomic<uint64_t> version_ {0};
+  boost::atomic<bool> live_ {false};
+
 public:
   Consumer();
   Consumer(const Consumer& other)
     : metadata_(other.metadata_)
-    , axes_ (other.axes_) {}
+    , axes_ (other.axes_)
+    , changed_ (other.changed_) {}
   virtual Consumer* clone() const = 0;
   virtual ~Consumer() {}
 
@@ -81,11 +136,33 @@ public:
   void push_spill(const Spill&);
   void flush();
 
+  //same, with events already built by a shared EventBuilder,
+  //whose anomaly totals so far are passed along
+  void push_events(const Spill&, const EventBatch&,
+                   const BuildCounts& counts = BuildCounts());
+
+  //false if sink cannot accept events built elsewhere
+  bool coincidence_setup(CoincidenceSetup&) const;
+
+  //incremented by every change to data or metadata
+  uint64_t version() const;
+
   //get count at coordinates in n-dimensional list
   PreciseFloat data(std::initializer_list<size_t> list = {}) const;
 
-  //optimized retrieval of bulk data as list of Entries
+  //bulk data into caller-owned columns, non-empty points only
   //parameters take dimensions_number of ranges (inclusive)
+  void data_columns(std::initializer_list<Pair> list, DataColumns& out) const;
+
+  //as data_columns, but sinks that support it return only points
+  //changed since the caller-owned epoch, which is then advanced;
+  //start from 0 for a full read
+  void data_delta(std::initializer_list<Pair> list, uint32_t& since, DataColumns& out) const;
+
+  //bulk data as dense row-major block over ranges (inclusive), last dimension fastest
+  void data_slab(std::initializer_list<Pair> list, std::vector<PreciseFloat>& out) const;
+
+  //same as data_columns, as list of Entries
   std::unique_ptr<EntryList> data_range(std::initializer_list<Pair> list = {});
   void append(const Entry&);
 
@@ -112,6 +189,14 @@ public:
   void set_detectors(const std::vector<Qpx::Detector>& dets);
 
 protected:
+  //consistent view of data, never blocks ongoing acquisition;
+  //null if there is nothing to read back (see _readable)
+  std::shared_ptr<const Consumer> snapshot() const;
+  //caller must hold unique_mutex_
+  void publish_snapshot() const;
+  //caller must hold unique_mutex_, at end of each ingest step
+  void changed_data();
+
   //////////////////////////////////////////
   //////////////////////////////////////////
   //////////THIS IS THE MEAT////////////////
@@ -124,13 +209,31 @@ protected:
 
   virtual void _set_detectors(const std::vector<Qpx::Detector>& dets) = 0;
   virtual void _push_spill(const Spill&);
+  virtual void _push_events(const Spill&, const EventBatch&);
+  virtual void _set_build_counts(const BuildCounts&) {}
   virtual void _push_hit(const Hit&) = 0;
+
+  //batch entry points; default _push_hits falls back to _push_hit
+  virtual void _push_hits(const HitBatch&);
+  virtual void _add_events(Span<Event>) {}
   virtual void _push_stats(const StatsUpdate&) = 0;
   virtual void _flush() {}
 
+  virtual bool _coincidence_setup(CoincidenceSetup&) const {return false;}
+
   virtual PreciseFloat _data(std::initializer_list<size_t>) const {return 0;}
-  virtual std::unique_ptr<std::list<Entry>> _data_range(std::initializer_list<Pair>)
-    { return std::unique_ptr<std::list<Entry>>(new std::list<Entry>); }
+  virtual void _data_columns(std::initializer_list<Pair>, DataColumns&) const {}
+  virtual void _data_delta(std::initializer_list<Pair> list, uint32_t&, DataColumns& out) const
+  { _data_columns(list, out); }
+  //false for sinks with no data to read back, e.g. list mode output;
+  //they are never copied for readers
+  virtual bool _readable() const {return true;}
+  //copy published to readers, made on the ingest thread; override to
+  //share storage or leave out state that only ingest needs
+  virtual Consumer* _snapshot_copy() const {return clone();}
+  //called on live object right after a snapshot is published, with
+  //unique_mutex_ held; may only touch state kept for snapshots
+  virtual void _snapshot_taken() const {}
   virtual void _append(const Entry&) {}
 
   virtual bool _write_file(std::string, std::string) const {return false;}
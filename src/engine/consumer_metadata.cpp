@@ -80,24 +80,37 @@ std::string ConsumerMetadata::debug(std::string prepend) const
 
 Setting ConsumerMetadata::get_attribute(Setting setting) const
 {
-  return attributes_.get_setting(setting, Match::id | Match::indices);
+  const Setting* found = index_.find(attributes_, setting, Match::id | Match::indices);
+  return found ? *found : Setting();
 }
 
 Setting ConsumerMetadata::get_attribute(std::string setting) const
 {
-  return attributes_.get_setting(Setting(setting), Match::id | Match::indices);
+  return get_attribute(Setting(setting));
 }
 
 Setting ConsumerMetadata::get_attribute(std::string setting, int32_t idx) const
 {
   Setting find(setting);
   find.indices.insert(idx);
-  return attributes_.get_setting(find, Match::id | Match::indices);
+  return get_attribute(find);
 }
 
 void ConsumerMetadata::set_attribute(const Setting &setting)
 {
-  attributes_.set_setting_r(setting, Match::id | Match::indices);
+  Setting* found = index_.find(attributes_, setting, Match::id | Match::indices);
+  if (found)
+    found->set_value(setting);
+}
+
+Setting* ConsumerMetadata::attribute(SettingHandle &handle)
+{
+  return index_.resolve(attributes_, handle);
+}
+
+const Setting* ConsumerMetadata::attribute(SettingHandle &handle) const
+{
+  return index_.resolve(attributes_, handle);
 }
 
 Setting ConsumerMetadata::get_all_attributes() const
@@ -115,13 +128,14 @@ void ConsumerMetadata::set_attributes(const Setting &settings)
   if (settings.branches.size())
     for (auto &s : settings.branches.my_data_)
       set_attributes(s);
-  else if (attributes_.has(settings, Match::id | Match::indices))
+  else
     set_attribute(settings);
 }
 
 void ConsumerMetadata::overwrite_all_attributes(Setting settings)
 {
   attributes_ = settings;
+  index_.invalidate();
 }
 
 void ConsumerMetadata::disable_presets()
@@ -154,6 +168,7 @@ void ConsumerMetadata::from_xml(const pugi::xml_node &node) {
 
   if (node.child(attributes_.xml_element_name().c_str()))
     attributes_.from_xml(node.child(attributes_.xml_element_name().c_str()));
+  index_.invalidate();
 
   if (node.child("Detectors")) {
     detectors.clear();
@@ -183,6 +198,7 @@ void from_json(const json& j, ConsumerMetadata &s)
 
   if (j.count("attributes"))
     s.attributes_ = j["attributes"];
+  s.index_.invalidate();
 
   if (j.count("detectors"))
   {
@@ -197,6 +213,8 @@ void ConsumerMetadata::set_det_limit(uint16_t limit)
   if (limit < 1)
     limit = 1;
 
+  index_.invalidate();
+
   for (auto &a : attributes_.branches.my_data_)
     if (a.metadata.setting_type == Qpx::SettingType::pattern)
       a.value_pattern.resize(limit);
@@ -31,6 +31,7 @@
 #pragma once
 
 #include "detector.h"
+#include "setting_index.h"
 
 #include "json.hpp"
 using namespace nlohmann;
@@ -51,6 +52,11 @@ public:
   Setting get_all_attributes() const;
   void set_attribute(const Setting &setting);
 
+  //cached lookup for hot paths; nullptr if absent,
+  //valid until attributes are restructured
+  Setting* attribute(SettingHandle &handle);
+  const Setting* attribute(SettingHandle &handle) const;
+
   Setting attributes() const;
   void set_attributes(const Setting &settings);
   void overwrite_all_attributes(Setting settings);
@@ -91,6 +97,7 @@ private:
 
   //can change these
   Setting attributes_ {"Options"};
+  SettingIndex index_;
 
 public:
   std::vector<Qpx::Detector> detectors;
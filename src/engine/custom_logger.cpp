@@ -19,13 +19,18 @@
 #include "custom_logger.h"
 
 #include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <boost/thread.hpp>
 #include <boost/core/null_deleter.hpp>
 #include <boost/log/support/date_time.hpp>
 #include <boost/log/expressions.hpp>
+#include <boost/log/sinks/basic_sink_frontend.hpp>
 #include <boost/log/sinks/text_ostream_backend.hpp>
 #include <boost/log/sinks/text_file_backend.hpp>
 #include <boost/log/utility/setup/common_attributes.hpp>
-#include <boost/log/sinks/async_frontend.hpp>
 #include <boost/log/sinks/sync_frontend.hpp>
 
 namespace logging = boost::log;
@@ -34,9 +39,232 @@ namespace expr = boost::log::expressions;
 namespace sinks = boost::log::sinks;
 namespace date = boost::date_time;
 
-typedef sinks::asynchronous_sink<sinks::text_ostream_backend, sinks::unbounded_fifo_queue> text_sink;
+typedef sinks::synchronous_sink<sinks::text_ostream_backend> text_sink;
 typedef sinks::synchronous_sink<sinks::text_file_backend> file_sink;
 
+namespace {
+
+struct QueuedRecord
+{
+  uint64_t seq {0};
+  logging::record_view rec;
+};
+
+//single producer (owning thread), single consumer (drain thread)
+class LogRing
+{
+public:
+  explicit LogRing(size_t capacity) : slots_(capacity) {}
+
+  bool push(QueuedRecord&& r)
+  {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if ((tail - head_.load(std::memory_order_acquire)) >= slots_.size())
+      return false;
+    slots_[tail % slots_.size()] = std::move(r);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  void drain(std::vector<QueuedRecord>& out)
+  {
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t tail = tail_.load(std::memory_order_acquire);
+    for (; head != tail; ++head)
+    {
+      QueuedRecord& slot = slots_[head % slots_.size()];
+      out.push_back(std::move(slot));
+      slot.rec = logging::record_view();
+    }
+    head_.store(head, std::memory_order_release);
+  }
+
+  bool empty() const
+  {
+    return (head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire));
+  }
+
+  std::atomic<bool> retired {false};  //owning thread has exited
+
+  //lower bound on the seq being taken and pushed by the owning thread,
+  //kIdle outside of that; records at or above it may not be visible yet
+  static const uint64_t kIdle = UINT64_MAX;
+  std::atomic<uint64_t> claiming {kIdle};
+
+private:
+  std::vector<QueuedRecord> slots_;
+  std::atomic<size_t> head_ {0};
+  std::atomic<size_t> tail_ {0};
+};
+
+//the calling thread's ring, tagged with the sink it was registered to
+struct LocalRing
+{
+  uint64_t owner {0};
+  std::shared_ptr<LogRing> ring;
+
+  ~LocalRing()
+  {
+    if (ring)
+      ring->retired.store(true);
+  }
+};
+
+thread_local LocalRing local_ring;
+std::atomic<uint64_t> sink_ids {0};
+
+//Accepts records on the logging thread without formatting or I/O and
+//hands them, in submission order, to ordinary synchronous sinks that
+//are driven only by the drain thread. A record is held back until no
+//thread can still publish one with a lower seq, so order holds across
+//drains too.
+class AsyncSink : public sinks::basic_sink_frontend
+{
+public:
+  static const size_t kRingSize = 8192;
+  static const int    kDrainMs = 20;
+
+  AsyncSink()
+    : sinks::basic_sink_frontend(true)
+    , id_(++sink_ids)
+  {}
+
+  ~AsyncSink() { stop(); }
+
+  void add_output(boost::shared_ptr<sinks::sink> s) { outputs_.push_back(s); }
+
+  void start()
+  {
+    running_.store(true);
+    thread_ = boost::thread(&AsyncSink::worker, this);
+  }
+
+  void stop()
+  {
+    if (!running_.exchange(false))
+      return;
+    thread_.interrupt();
+    thread_.join();
+    flush();
+  }
+
+  void consume(logging::record_view const& rec) override
+  {
+    if (local_ring.owner != id_)
+      register_thread();
+    LogRing& ring = *local_ring.ring;
+    ring.claiming.store(seq_.load());
+    QueuedRecord r;
+    r.seq = seq_.fetch_add(1);
+    r.rec = rec;
+    if (!ring.push(std::move(r)))
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+    ring.claiming.store(LogRing::kIdle);
+  }
+
+  bool try_consume(logging::record_view const& rec) override
+  {
+    consume(rec);
+    return true;
+  }
+
+  void flush() override
+  {
+    drain();
+    for (auto &o : outputs_)
+      o->flush();
+  }
+
+  uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+  uint64_t id_;
+  std::vector<boost::shared_ptr<sinks::sink>> outputs_;
+
+  boost::mutex rings_mutex_;
+  std::vector<std::shared_ptr<LogRing>> rings_;
+
+  boost::mutex drain_mutex_;
+  std::vector<QueuedRecord> batch_;  //sorted; held back between drains
+
+  std::atomic<uint64_t> seq_ {0};
+  std::atomic<uint64_t> dropped_ {0};
+  uint64_t dropped_reported_ {0};
+
+  std::atomic<bool> running_ {false};
+  boost::thread thread_;
+
+  void register_thread()
+  {
+    if (local_ring.ring)
+      local_ring.ring->retired.store(true);
+    local_ring.ring = std::make_shared<LogRing>(size_t(kRingSize));
+    local_ring.owner = id_;
+    boost::unique_lock<boost::mutex> lock(rings_mutex_);
+    rings_.push_back(local_ring.ring);
+  }
+
+  void drain()
+  {
+    boost::unique_lock<boost::mutex> lock(drain_mutex_);
+
+    //every seq below this was taken before we look at the rings
+    uint64_t watermark = seq_.load();
+
+    std::vector<std::shared_ptr<LogRing>> rings;
+    {
+      boost::unique_lock<boost::mutex> rlock(rings_mutex_);
+      //retired is set after the thread's last push
+      rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                  [](const std::shared_ptr<LogRing>& r)
+                                  { return r->retired.load() && r->empty(); }),
+                   rings_.end());
+      rings = rings_;
+    }
+
+    //a thread still between taking its seq and pushing holds it back
+    for (auto &r : rings)
+      watermark = std::min(watermark, r->claiming.load());
+
+    for (auto &r : rings)
+      r->drain(batch_);
+
+    std::sort(batch_.begin(), batch_.end(),
+              [](const QueuedRecord& a, const QueuedRecord& b) { return a.seq < b.seq; });
+
+    auto ready = std::partition_point(batch_.begin(), batch_.end(),
+                                      [watermark](const QueuedRecord& q) { return q.seq < watermark; });
+    for (auto q = batch_.begin(); q != ready; ++q)
+      for (auto &o : outputs_)
+        if (o->will_consume(q->rec.attribute_values()))
+          o->consume(q->rec);
+    batch_.erase(batch_.begin(), ready);
+  }
+
+  void worker()
+  {
+    while (running_.load())
+    {
+      drain();
+
+      uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+      if (dropped != dropped_reported_)
+      {
+        WARN << "<CustomLogger> " << (dropped - dropped_reported_)
+             << " log records dropped, ring buffer full";
+        dropped_reported_ = dropped;
+      }
+
+      try { boost::this_thread::sleep(boost::posix_time::milliseconds(long(kDrainMs))); }
+      catch (boost::thread_interrupted&) { break; }
+    }
+  }
+};
+
+boost::shared_ptr<AsyncSink> async_sink;
+
+}
+
 void CustomLogger::initLogger(std::ostream *gui_stream, std::string log_file_N)
 {
   logging::add_common_attributes();
@@ -55,6 +283,9 @@ void CustomLogger::initLogger(std::ostream *gui_stream, std::string log_file_N)
   
   boost::shared_ptr< logging::core > core = logging::core::get();
 
+  //outputs below are driven by the drain thread only
+  boost::shared_ptr<AsyncSink> sink_async = boost::make_shared<AsyncSink>();
+
   // GUI
   if (gui_stream != nullptr) {
     boost::shared_ptr<sinks::text_ostream_backend> backend_gui = boost::make_shared<sinks::text_ostream_backend>();
@@ -62,7 +293,7 @@ void CustomLogger::initLogger(std::ostream *gui_stream, std::string log_file_N)
     boost::shared_ptr<text_sink> sink_gui(new text_sink(backend_gui));
     sink_gui->set_formatter(format_basic);
     sink_gui->set_filter(expr::attr<SeverityLevel>("Severity") >= kInfo);
-    core->add_sink(sink_gui);
+    sink_async->add_output(sink_gui);
   }
 
   // console
@@ -72,7 +303,7 @@ void CustomLogger::initLogger(std::ostream *gui_stream, std::string log_file_N)
   sink_console->locked_backend()->auto_flush(true);
   sink_console->set_formatter(format_verbose);
   sink_console->set_filter(expr::attr<SeverityLevel>("Severity") >= kDebug);
-  core->add_sink(sink_console);
+  sink_async->add_output(sink_console);
 
   // file
   boost::shared_ptr<sinks::text_file_backend> backend_file = boost::make_shared<sinks::text_file_backend>(
@@ -86,12 +317,24 @@ void CustomLogger::initLogger(std::ostream *gui_stream, std::string log_file_N)
   sink_file->locked_backend()->auto_flush(true);
   sink_file->set_formatter(format_verbose);
   sink_file->set_filter(expr::attr<SeverityLevel >("Severity") >= kTrace);
-  core->add_sink(sink_file);
+  sink_async->add_output(sink_file);
+
+  sink_async->start();
+  core->add_sink(sink_async);
+  async_sink = sink_async;
 }
 
 void CustomLogger::closeLogger()
 {
   DBG << "<CustomLogger> Closing logger sinks";
   logging::core::get()->remove_all_sinks();
+  if (async_sink) {
+    async_sink->stop();
+    async_sink.reset();
+  }
 }
 
+uint64_t CustomLogger::droppedRecords()
+{
+  return async_sink ? async_sink->dropped() : 0;
+}
@@ -13,6 +13,9 @@
  *
  * Description:
  *      Utility based on boost log for output to file, console and gui.
+ *      Records are queued on per-thread rings and written by a background
+ *      thread; when a ring is full the record is dropped and counted.
+ *      TRC and DBG may be compiled out with QPX_LOG_MIN_LEVEL.
  *
  ******************************************************************************/
 
@@ -20,6 +23,7 @@
 
 #include <iostream>
 #include <string>
+#include <cstdint>
 #include <boost/log/core.hpp>
 #include <boost/log/expressions/keyword.hpp>
 #include <boost/log/sources/record_ostream.hpp>
@@ -32,6 +36,9 @@ namespace CustomLogger {
   void initLogger(std::ostream *gui_stream, std::string log_file_N);
   void closeLogger();
 
+  //records lost to full rings since initLogger
+  uint64_t droppedRecords();
+
   enum SeverityLevel
   {
     kTrace,
@@ -65,8 +72,26 @@ BOOST_LOG_ATTRIBUTE_KEYWORD(g_severity, "Severity", CustomLogger::SeverityLevel)
 BOOST_LOG_INLINE_GLOBAL_LOGGER_DEFAULT(g_custom_logger,
                                        boost::log::sources::severity_logger_mt<CustomLogger::SeverityLevel>)
 
+//levels below this are not compiled in: 0 keeps all, 1 drops TRC, 2 also DBG
+#ifndef QPX_LOG_MIN_LEVEL
+#define QPX_LOG_MIN_LEVEL 0
+#endif
+
+//still type-checked, never evaluated
+#define QPX_LOG_DISABLED while (false) BOOST_LOG_SEV(g_custom_logger::get(), CustomLogger::kTrace)
+
+#if QPX_LOG_MIN_LEVEL > 0
+#define TRC QPX_LOG_DISABLED
+#else
 #define TRC BOOST_LOG_SEV(g_custom_logger::get(), CustomLogger::kTrace)
+#endif
+
+#if QPX_LOG_MIN_LEVEL > 1
+#define DBG QPX_LOG_DISABLED
+#else
 #define DBG BOOST_LOG_SEV(g_custom_logger::get(), CustomLogger::kDebug)
+#endif
+
 #define LINFO BOOST_LOG_SEV(g_custom_logger::get(), CustomLogger::kInfo)
 #define WARN BOOST_LOG_SEV(g_custom_logger::get(), CustomLogger::kWarning)
 #define ERR BOOST_LOG_SEV(g_custom_logger::get(), CustomLogger::kError)
@@ -53,6 +53,11 @@ public:
     return bits_;
   }
 
+  inline uint16_t native() const
+  {
+    return val_;
+  }
+
   inline uint16_t val(uint16_t bits) const
   {
     if (bits == bits_)
@@ -0,0 +1,102 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Single thread executing queued jobs in order, with a barrier
+ *      for waiting until all queued jobs are done.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <queue>
+#include <memory>
+#include <boost/thread.hpp>
+#include <boost/function.hpp>
+
+namespace Qpx {
+
+class DispatchWorker
+{
+public:
+  typedef boost::function<void()> Job;
+
+  inline DispatchWorker()
+    : thread_(boost::bind(&DispatchWorker::run, this))
+  {}
+
+  inline ~DispatchWorker()
+  {
+    wait_idle();
+    {
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      end_queue_ = true;
+    }
+    cond_.notify_all();
+    thread_.join();
+  }
+
+  //returns jobs pending, including this one
+  inline size_t enqueue(const Job& job)
+  {
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    jobs_.push(job);
+    pending_++;
+    cond_.notify_all();
+    return pending_;
+  }
+
+  inline void wait_idle()
+  {
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    while (pending_ > 0)
+      cond_.wait(lock);
+  }
+
+private:
+  bool end_queue_ {false};
+  size_t pending_ {0};
+  std::queue<Job> jobs_;
+  boost::mutex mutex_;
+  boost::condition_variable cond_;
+  boost::thread thread_; //last, so the rest is ready when it starts
+
+  inline void run()
+  {
+    while (true)
+    {
+      Job job;
+      {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        while (jobs_.empty() && !end_queue_)
+          cond_.wait(lock);
+        if (jobs_.empty())
+          return;
+        job = jobs_.front();
+        jobs_.pop();
+      }
+
+      job();
+
+      {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        pending_--;
+      }
+      cond_.notify_all();
+    }
+  }
+};
+
+typedef std::shared_ptr<DispatchWorker> DispatchWorkerPtr;
+
+}
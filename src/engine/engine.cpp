@@ -26,6 +26,7 @@
 #include "custom_logger.h"
 #include "producer_factory.h"
 #include <iomanip>
+#include <algorithm>
 #include "compiletime.h"
 
 namespace Qpx {
@@ -112,7 +113,10 @@ void Engine::initialize(std::string profile_path, std::string settings_path) {
     }
   }
 
-  push_settings(tree);
+  //whole new tree, nothing to diff against
+  settings_tree_ = tree;
+  settings_index_.invalidate();
+  write_settings_bulk();
   get_all_settings();
 
   if (!descr.value_text.empty())
@@ -144,13 +148,40 @@ Qpx::Setting Engine::pull_settings() const {
   return settings_tree_;
 }
 
-void Engine::push_settings(const Qpx::Setting& newsettings) {
-  settings_tree_ = newsettings;
+bool Engine::push_settings(const Qpx::Setting& newsettings) {
+  std::list<Qpx::SettingPath> changed;
+  if (apply_changes(settings_tree_, newsettings, changed)) {
+    if (changed.empty() || write_changes(changed))
+      return true;
+  } else {
+    settings_tree_ = newsettings;
+    settings_index_.invalidate();
+  }
   write_settings_bulk();
+  return false;
 
 //  LINFO << "settings pushed branches = " << settings_tree_.branches.size();
 }
 
+bool Engine::write_changes(const std::list<Qpx::SettingPath>& changed) {
+  std::map<Qpx::Setting*, std::list<Qpx::SettingPath>> by_device;
+  std::set<int32_t> affected;
+  for (auto &path : changed) {
+    if (path.empty() || !devices_.count(path.front()->id_))
+      return false;  //e.g. Detectors branch, which is structural
+    by_device[path.front()].push_back(path);
+    for (auto &node : path)
+      affected.insert(node->indices.begin(), node->indices.end());
+  }
+
+  for (auto &d : by_device)
+    if (!devices_[d.first->id_]->write_settings(*d.first, d.second))
+      return false;
+
+  save_optimization(affected);
+  return true;
+}
+
 bool Engine::read_settings_bulk(){
   for (auto &set : settings_tree_.branches.my_data_)
   {
@@ -181,6 +212,7 @@ bool Engine::read_settings_bulk(){
     }
 
   }
+  settings_index_.invalidate();
   save_optimization();
   return true;
 }
@@ -194,6 +226,7 @@ bool Engine::write_settings_bulk(){
       devices_[set.id_]->write_settings_bulk(set);
     }
   }
+  settings_index_.invalidate();
   return true;
 }
 
@@ -260,7 +293,15 @@ std::vector<Hit> Engine::oscilloscope() {
   return traces;
 }
 
-bool Engine::daq_start(SynchronizedQueue<Spill*>* out_queue) {
+void Engine::set_spill_queue(size_t capacity, BoundedSpillQueue::Policy policy,
+                             std::string overflow_dir) {
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  queue_capacity_ = capacity;
+  queue_policy_ = policy;
+  queue_overflow_dir_ = overflow_dir;
+}
+
+bool Engine::daq_start(SpillQueue out_queue) {
   bool success = false;
   for (auto &q : devices_)
     if ((q.second != nullptr) && (q.second->status() & ProducerStatus::can_run)) {
@@ -311,6 +352,18 @@ void Engine::set_detector(size_t ch, Qpx::Detector det)
   }
 }
 
+void Engine::save_optimization(const std::set<int32_t>& detectors)
+{
+  for (auto &i : detectors)
+  {
+    if ((i < 0) || (i >= static_cast<int32_t>(detectors_.size())))
+      continue;
+    Setting t;
+    t.indices.insert(i);
+    detectors_[i].add_optimizations(settings_index_.find_all(settings_tree_, t, Qpx::Match::indices));
+  }
+}
+
 void Engine::save_optimization()
 {
   for (size_t i = 0; i < detectors_.size(); i++)
@@ -319,7 +372,7 @@ void Engine::save_optimization()
 //    detectors_[i].settings_ = Qpx::Setting();
     Setting t;
     t.indices.insert(i);
-    detectors_[i].add_optimizations(settings_tree_.find_all(t, Qpx::Match::indices));
+    detectors_[i].add_optimizations(settings_index_.find_all(settings_tree_, t, Qpx::Match::indices));
   }
 }
 
@@ -338,17 +391,29 @@ void Engine::load_optimization(size_t i)
     if (!s.metadata.writable)
       continue;
     s.indices.insert(i);
-    settings_tree_.set_setting_r(s, Qpx::Match::id | Qpx::Match::indices);
+    if (Setting* found = settings_index_.find(settings_tree_, s, Qpx::Match::id | Qpx::Match::indices))
+      found->set_value(s);
   }
 }
 
-void Engine::set_setting(Qpx::Setting address, Qpx::Match flags) {
-  if (settings_tree_.set_setting_r(address, flags))
+bool Engine::set_setting(Qpx::Setting address, Qpx::Match flags) {
+  Setting* found = nullptr;
+  if (SettingIndex::indexable(flags))
+    found = settings_index_.find(settings_tree_, address, flags);
+
+  if (found) {
+    if (values_equal(*found, address))
+      return true;
+    found->set_value(address);
+    if (write_changes({settings_index_.path(settings_tree_, found)}))
+      return true;
+  } else if (settings_tree_.set_setting_r(address, flags))
   {
 //    DBG << "<Engine> Success setting " << address.id_;
   }
   write_settings_bulk();
   read_settings_bulk();
+  return false;
 }
 
 void Engine::get_all_settings() {
@@ -382,15 +447,16 @@ void Engine::getMca(uint64_t timeout, ProjectPtr spectra, boost::atomic<bool>& i
   CustomTimer *anouncement_timer = nullptr;
   double secs_between_anouncements = 5;
 
-  SynchronizedQueue<Spill*> parsedQueue;
+  BoundedSpillQueue parsedQueue(queue_capacity_, queue_policy_, queue_overflow_dir_);
 
+  PipelineMetrics::get().reset();
   boost::thread builder(boost::bind(&Qpx::Engine::worker_MCA, this, &parsedQueue, spectra));
 
-  Spill* spill = new Spill;
+  std::unique_ptr<Spill> spill(new Spill);
   get_all_settings();
   spill->state = pull_settings();
   spill->detectors = get_detectors();
-  parsedQueue.enqueue(spill);
+  parsedQueue.enqueue(std::move(spill));
 
   if (daq_start(&parsedQueue))
     DBG << "<Engine> Started device daq threads";
@@ -420,10 +486,10 @@ void Engine::getMca(uint64_t timeout, ProjectPtr spectra, boost::atomic<bool>& i
 
   delete anouncement_timer;
 
-  spill = new Spill;
+  spill.reset(new Spill);
   get_all_settings();
   spill->state = pull_settings();
-  parsedQueue.enqueue(spill);
+  parsedQueue.enqueue(std::move(spill));
 
   wait_ms(500);
   while (parsedQueue.size() > 0)
@@ -432,6 +498,8 @@ void Engine::getMca(uint64_t timeout, ProjectPtr spectra, boost::atomic<bool>& i
   wait_ms(500);
 
   builder.join();
+  DBG << "<Engine> Spill queue " << parsedQueue.stats().to_string();
+  DBG << "<Engine> " << metrics().to_string();
   LINFO << "<Engine> Acquisition finished";
 }
 
@@ -461,8 +529,9 @@ ListData Engine::getList(uint64_t timeout, boost::atomic<bool>& interruptor) {
   one_spill->detectors = get_detectors();
   result.push_back(SpillPtr(one_spill));
 
-  SynchronizedQueue<Spill*> parsedQueue;
+  BoundedSpillQueue parsedQueue(queue_capacity_, queue_policy_, queue_overflow_dir_);
 
+  PipelineMetrics::get().reset();
   if (daq_start(&parsedQueue))
     DBG << "<Engine> Started device daq threads";
 
@@ -471,6 +540,9 @@ ListData Engine::getList(uint64_t timeout, boost::atomic<bool>& interruptor) {
 
   while (daq_running()) {
     wait_ms(1000);
+    //drain as we go, or a bounded queue would stall the devices
+    while (parsedQueue.size() > 0)
+      result.push_back(SpillPtr(parsedQueue.dequeue().release()));
     if (anouncement_timer->s() > secs_between_anouncements) {
       LINFO << "  RUNNING Elapsed: " << total_timer.done()
               << "  ETA: " << total_timer.ETA();
@@ -490,28 +562,38 @@ ListData Engine::getList(uint64_t timeout, boost::atomic<bool>& interruptor) {
   one_spill = new Spill;
   get_all_settings();
   one_spill->state = pull_settings();
-  parsedQueue.enqueue(one_spill);
+  parsedQueue.enqueue(std::unique_ptr<Spill>(one_spill));
 //  result.push_back(SpillPtr(one_spill));
 
   wait_ms(500);
 
   while (parsedQueue.size() > 0)
-    result.push_back(SpillPtr(parsedQueue.dequeue()));
+    result.push_back(SpillPtr(parsedQueue.dequeue().release()));
 
 
   parsedQueue.stop();
+  DBG << "<Engine> Spill queue " << parsedQueue.stats().to_string();
   return result;
 }
 
 //////STUFF BELOW SHOULD NOT BE USED DIRECTLY////////////
 //////ASSUME YOU KNOW WHAT YOU'RE DOING WITH THREADS/////
 
-void Engine::worker_MCA(SynchronizedQueue<Spill*>* data_queue,
+void Engine::worker_MCA(SpillQueue data_queue,
                         ProjectPtr spectra) {
 
   CustomTimer presort_timer;
   uint64_t presort_compares(0), presort_hits(0), presort_cycles(0);
 
+  StageMetrics* queue_stage   = PipelineMetrics::get().stage(Stage::queue);
+  StageMetrics* presort_stage = PipelineMetrics::get().stage(Stage::presort);
+
+  typedef std::pair<TimeStamp, Spill*> SpillHead;
+  auto later = [&presort_compares](const SpillHead& a, const SpillHead& b) {
+    presort_compares++;
+    return (a.first > b.first);
+  };
+
   std::map<int16_t, bool> queue_status;
   // for each input channel (detector) false = empty, true = data
 
@@ -521,7 +603,10 @@ void Engine::worker_MCA(SynchronizedQueue<Spill*>* data_queue,
   Spill* in_spill  = nullptr;
   Spill* out_spill = nullptr;
   while (true) {
-    in_spill = data_queue->dequeue();
+    queue_stage->depth(data_queue->size());
+    StageTimer queue_wait(queue_stage);
+    in_spill = data_queue->dequeue().release();
+    queue_wait.stop();
     if (in_spill != nullptr) {
       for (auto &q : in_spill->stats) {
         if (q.second.source_channel >= 0) {
@@ -563,39 +648,45 @@ void Engine::worker_MCA(SynchronizedQueue<Spill*>* data_queue,
 
 
       presort_cycles++;
-      presort_timer.start();
+      presort_timer.resume();
+      uint64_t cycle_start = presort_hits;
+      StageTimer presort_pass(presort_stage);
+
+      //k-way merge: heap of spill heads, oldest hit on top
+      std::vector<SpillHead> heads;
+      heads.reserve(current_spills.size());
+      if (current_spills.empty())
+        empty = true;
+      for (auto &q : current_spills) {
+        if (empty)
+          break;
+        else if (q->hits.empty())
+          empty = true;
+        else
+          heads.push_back(SpillHead(q->hits.timestamp(0), q));
+      }
+
+      if (!empty)
+        std::make_heap(heads.begin(), heads.end(), later);
+
       while (!empty) {
-        Hit oldest;
-        for (auto &q : current_spills) {
-          if (q->hits.empty()) {
-            empty = true;
-            break;
-          } else if ((oldest == Hit()) || (q->hits.front().timestamp() < oldest.timestamp())) {
-            oldest = q->hits.front();
-            presort_compares++;
-          }
-        }
-        if (!empty) {
-          presort_hits++;
-          out_spill->hits.push_back(oldest);
-          for (auto &q : current_spills)
-            if ((!q->hits.empty()) && (q->hits.front().timestamp() == oldest.timestamp())) {
-              q->hits.pop_front();
-              presort_compares++;
-              break;
-            }
-        }
-        if (current_spills.empty())
+        std::pop_heap(heads.begin(), heads.end(), later);
+        Spill* oldest = heads.back().second;
+        out_spill->hits.append(oldest->hits, 0);
+        oldest->hits.pop_front();
+        presort_hits++;
+
+        //a drained spill is the watermark; nothing beyond it is safe to emit
+        if (oldest->hits.empty())
           empty = true;
+        else {
+          heads.back().first = oldest->hits.timestamp(0);
+          std::push_heap(heads.begin(), heads.end(), later);
+        }
       }
       presort_timer.stop();
-
-//      DBG << "<Engine> Presort pushed " << presort_hits << " hits, ";
-//                               " time/hit: " << presort_timer.us()/presort_hits << "us, "
-//                               " time/cycle: " << presort_timer.us()/presort_cycles  << "us, "
-//                               " compares/hit: " << double(presort_compares)/double(presort_hits) << ", "
-//                               " hits/cyle: " << double(presort_hits)/double(presort_cycles) << ", "
-//                               " compares/cycle: " << double(presort_compares)/double(presort_cycles);
+      presort_pass.items(presort_hits - cycle_start);
+      presort_pass.stop();
 
       bool noempties = false;
       while (!noempties) {
@@ -608,12 +699,11 @@ void Engine::worker_MCA(SynchronizedQueue<Spill*>* data_queue,
             out_spill->stats = (*i)->stats;
             out_spill->detectors = (*i)->detectors;
             out_spill->state = (*i)->state;
-            spectra->add_spill(out_spill);
+            spectra->add_spill(SpillPtr(out_spill));
 
             delete (*i);
             current_spills.erase(i);
 
-            delete out_spill;
             out_spill = new Spill;
             noempties = false;
             break;
@@ -626,6 +716,15 @@ void Engine::worker_MCA(SynchronizedQueue<Spill*>* data_queue,
       break;
   }
 
+  if (presort_hits && presort_cycles)
+    DBG << "<Engine> Presort pushed " << presort_hits << " hits in "
+        << presort_timer.ms() << " ms,"
+        << " rate: " << presort_hits / (presort_timer.s() > 0 ? presort_timer.s() : 1.0) << " hits/s,"
+        << " time/hit: " << presort_timer.us() / presort_hits << "us,"
+        << " time/cycle: " << presort_timer.us() / presort_cycles << "us,"
+        << " compares/hit: " << double(presort_compares) / double(presort_hits) << ","
+        << " hits/cycle: " << double(presort_hits) / double(presort_cycles);
+
   DBG << "<Engine> Spectra builder terminating";
 
   spectra->flush();
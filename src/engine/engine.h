@@ -25,15 +25,18 @@
 #include "detector.h"
 #include "setting.h"
 #include "producer.h"
-#include "synchronized_queue.h"
 #include "project.h"
 
 #include "custom_timer.h"
+#include "pipeline_metrics.h"
+#include "setting_index.h"
 
 namespace Qpx {
 
 class Engine {
   
+  friend class PipelineBench;  //drives worker_MCA directly
+
 public:
 
   static Engine& getInstance()
@@ -56,21 +59,29 @@ public:
 
   void load_optimization();
 
-  void set_setting(Qpx::Setting address, Qpx::Match flags);
+  //true if applied incrementally; otherwise a bulk round trip was done
+  bool set_setting(Qpx::Setting address, Qpx::Match flags);
 
   /////SETTINGS/////
   Qpx::Setting pull_settings() const;
-  void push_settings(const Qpx::Setting&);
+  bool push_settings(const Qpx::Setting&);
   bool write_settings_bulk();
   bool read_settings_bulk(); 
   void get_all_settings();
 
   std::vector<Hit> oscilloscope();
+
+  //spill queue between devices and spectra builder
+  void set_spill_queue(size_t capacity, BoundedSpillQueue::Policy policy,
+                       std::string overflow_dir = "");
   
-  bool daq_start(SynchronizedQueue<Spill*>* out_queue);
+  bool daq_start(SpillQueue out_queue);
   bool daq_stop();
   bool daq_running();
 
+  //per-stage counters and latencies since the current or last run began
+  MetricsSnapshot metrics() const { return PipelineMetrics::get().snapshot(); }
+
   static int print_version();
   static std::string version();
 
@@ -82,16 +93,21 @@ protected:
   std::map<std::string, ProducerPtr> devices_;
 
   Qpx::Setting settings_tree_;
+  Qpx::SettingIndex settings_index_;  //invalidate on any structural change
   Qpx::SettingMeta total_det_num_, single_det_;
 
   std::vector<Qpx::Detector> detectors_;
 
+  size_t                    queue_capacity_ {1024};
+  BoundedSpillQueue::Policy queue_policy_ {BoundedSpillQueue::Policy::block};
+  std::string               queue_overflow_dir_;
+
   void save_det_settings(Qpx::Setting&, const Qpx::Setting&, Qpx::Match flags) const;
   void load_det_settings(Qpx::Setting, Qpx::Setting&, Qpx::Match flags);
   void rebuild_structure(Qpx::Setting &set);
 
   //threads
-  void worker_MCA(SynchronizedQueue<Spill*>* data_queue, ProjectPtr spectra);
+  void worker_MCA(SpillQueue data_queue, ProjectPtr spectra);
 
 private:
 
@@ -102,8 +118,12 @@ private:
   ~Engine();
 
   void save_optimization();
+  void save_optimization(const std::set<int32_t>& detectors);
   void load_optimization(size_t);
 
+  //change set to owning devices; false if any needs a bulk round trip
+  bool write_changes(const std::list<Qpx::SettingPath>& changed);
+
 };
 
 }
@@ -39,11 +39,10 @@ bool Event::antecedent(const Hit& h) const {
 }
 
 bool Event::addHit(const Hit &newhit) {
-  if (hits.count(newhit.source_channel()))
+  if (!hits.insert(newhit))
     return false;
   if (lower_time > newhit.timestamp())
     lower_time = newhit.timestamp();
-  hits[newhit.source_channel()] = newhit;
   return true;
 }
 
@@ -51,7 +50,7 @@ std::string Event::to_string() const {
   std::stringstream ss;
   ss << "EVT[t" << lower_time.to_string() << "w" << window_ns << "]";
   for (auto &q : hits)
-    ss << " " << q.first << "=" << q.second.to_string();
+    ss << " " << q.source_channel() << "=" << q.to_string();
   return ss.str();
 }
 
@@ -24,16 +24,116 @@
 #pragma once
 
 #include "hit.h"
-#include <map>
+#include "channel_mask.h"
+#include "span.h"
+#include <stdexcept>
+#include <algorithm>
 #include "xmlable.h"
 
 namespace Qpx {
 
+//at most one hit per channel, kept in channel order;
+//the occupancy mask locates a channel's slot by rank. Channels the mask
+//cannot hold go to the ends of the same vector (negative ones before,
+//ChannelMask::kChannels and above after) and are found by binary search.
+class EventHits
+{
+public:
+  inline size_t size() const { return slots_.size(); }
+  inline bool empty() const { return slots_.empty(); }
+
+  //channels in ChannelMask range only
+  inline const ChannelMask& mask() const { return mask_; }
+
+  //hits on channels outside mask range
+  inline bool has_overflow() const { return (low_ + high_) > 0; }
+
+  inline size_t count(int16_t chan) const
+  {
+    if (ChannelMask::in_range(chan))
+      return mask_.test(chan) ? 1 : 0;
+    return (find_overflow(chan) != slots_.end()) ? 1 : 0;
+  }
+
+  inline const Hit& at(int16_t chan) const
+  {
+    if (ChannelMask::in_range(chan))
+    {
+      if (!mask_.test(chan))
+        throw std::out_of_range("EventHits::at");
+      return slots_[low_ + mask_.rank(chan)];
+    }
+    auto it = find_overflow(chan);
+    if (it == slots_.end())
+      throw std::out_of_range("EventHits::at");
+    return *it;
+  }
+
+  //false if channel is occupied
+  inline bool insert(const Hit& hit)
+  {
+    int16_t chan = hit.source_channel();
+    if (ChannelMask::in_range(chan))
+    {
+      if (mask_.test(chan))
+        return false;
+      slots_.insert(slots_.begin() + low_ + mask_.rank(chan), hit);
+      mask_.set(chan);
+      return true;
+    }
+
+    bool below = (chan < 0);
+    auto first = below ? slots_.begin() : slots_.end() - high_;
+    auto last  = below ? slots_.begin() + low_ : slots_.end();
+    auto it = std::lower_bound(first, last, chan, by_channel);
+    if ((it != last) && (it->source_channel() == chan))
+      return false;
+    slots_.insert(it, hit);
+    if (below)
+      low_++;
+    else
+      high_++;
+    return true;
+  }
+
+  inline void clear()
+  {
+    slots_.clear();
+    mask_.clear();
+    low_ = high_ = 0;
+  }
+
+  inline std::vector<Hit>::const_iterator begin() const { return slots_.begin(); }
+  inline std::vector<Hit>::const_iterator end() const { return slots_.end(); }
+
+private:
+  ChannelMask mask_;
+  std::vector<Hit> slots_;
+  size_t low_ {0};   //leading slots with negative channels
+  size_t high_ {0};  //trailing slots with channels past mask range
+
+  static inline bool by_channel(const Hit& h, int16_t chan)
+  {
+    return h.source_channel() < chan;
+  }
+
+  inline std::vector<Hit>::const_iterator find_overflow(int16_t chan) const
+  {
+    bool below = (chan < 0);
+    auto first = below ? slots_.begin() : slots_.end() - high_;
+    auto last  = below ? slots_.begin() + low_ : slots_.end();
+    auto it = std::lower_bound(first, last, chan, by_channel);
+    if ((it != last) && (it->source_channel() == chan))
+      return it;
+    return slots_.end();
+  }
+};
+
 struct Event {
   TimeStamp              lower_time;
   double                 window_ns;
   double                 max_delay_ns;
-  std::map<int16_t, Hit> hits;
+  EventHits              hits;
 
   bool in_window(const Hit& h) const;
   bool past_due(const Hit& h) const;
@@ -49,10 +149,13 @@ struct Event {
 
   inline Event(const Hit &newhit, double win, double max_delay) {
     lower_time = newhit.timestamp();
-    hits[newhit.source_channel()] = newhit;
+    hits.insert(newhit);
     window_ns = win;
     max_delay_ns = std::max(win, max_delay);
   }
 };
 
+//finished events, in order of completion
+typedef std::vector<Event> EventBatch;
+
 }
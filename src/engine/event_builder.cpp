@@ -0,0 +1,132 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * This software can be redistributed and/or modified freely provided that
+ * any derivative works bear some notice that they are derived from it, and
+ * any modified versions bear some notice that they have been modified.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ ******************************************************************************/
+
+#include "event_builder.h"
+
+namespace Qpx {
+
+double CoincidenceSetup::max_delay() const
+{
+  double max = 0;
+  for (auto &d : delay_ns)
+    if (d > max)
+      max = d;
+  return max + coinc_window;
+}
+
+bool CoincidenceSetup::operator<(const CoincidenceSetup& other) const
+{
+  if (coinc_window != other.coinc_window)
+    return (coinc_window < other.coinc_window);
+  if (bits != other.bits)
+    return (bits < other.bits);
+  if (delay_ns != other.delay_ns)
+    return (delay_ns < other.delay_ns);
+  if (cutoff_logic != other.cutoff_logic)
+    return (cutoff_logic < other.cutoff_logic);
+  return (relevant < other.relevant);
+}
+
+bool CoincidenceSetup::operator==(const CoincidenceSetup& other) const
+{
+  return ((coinc_window == other.coinc_window)
+          && (bits == other.bits)
+          && (delay_ns == other.delay_ns)
+          && (cutoff_logic == other.cutoff_logic)
+          && (relevant == other.relevant));
+}
+
+EventBuilder::EventBuilder(const CoincidenceSetup& setup)
+  : setup_(setup)
+{
+  if (setup_.coinc_window < 0)
+    setup_.coinc_window = 0;
+  max_delay_ = setup_.max_delay();
+  window_ = CoincidenceWindow(setup_.coinc_window, max_delay_);
+}
+
+void EventBuilder::push_spill(const Spill& one_spill, EventBatch& finished)
+{
+  push_hits(one_spill.hits, finished);
+
+  for (auto &q : one_spill.stats)
+    push_stats(q.second);
+}
+
+void EventBuilder::push_stats(const StatsUpdate& newBlock)
+{
+  if (!setup_.is_relevant(newBlock.source_channel))
+    return;
+
+  int16_t chan = newBlock.source_channel;
+  if ((newBlock.stats_type == StatsUpdate::Type::start) || !plan_.find(chan))
+    plan_.compile(chan, newBlock.model_hit, setup_.bits,
+                  (chan < static_cast<int16_t>(setup_.cutoff_logic.size())) ? setup_.cutoff_logic[chan] : 0,
+                  (chan < static_cast<int16_t>(setup_.delay_ns.size())) ? setup_.delay_ns[chan] : 0,
+                  true);
+
+  window_.add_timebase(newBlock.model_hit.timebase);
+}
+
+void EventBuilder::push_hit(const Hit& newhit, EventBatch& finished)
+{
+  const ChannelPlan* plan = plan_.find(newhit.source_channel());
+  if (!plan || !plan->relevant || !plan->passes(newhit))
+    return;
+  push_planned(newhit, *plan, finished);
+}
+
+void EventBuilder::push_hits(const HitBatch& hits, EventBatch& finished)
+{
+  const int16_t* channels = hits.channels();
+  for (size_t i=0; i < hits.size(); ++i)
+  {
+    const ChannelPlan* plan = plan_.find(channels[i]);
+    if (!plan || !plan->relevant)
+      continue;
+    const uint16_t* energies = (plan->value_idx >= 0) ? hits.values(plan->value_idx) : nullptr;
+    if (!plan->passes(energies ? energies[i] : uint16_t(0)))
+      continue;
+    push_planned(hits[i], *plan, finished);
+  }
+}
+
+void EventBuilder::push_planned(const Hit& newhit, const ChannelPlan& plan,
+                                EventBatch& finished)
+{
+  CoincidenceWindow::Placement placed;
+  if (plan.delay_native)
+  {
+    Hit hit = newhit;
+    hit.delay_native(plan.delay_native);
+    placed = window_.push(hit, finished);
+  }
+  else
+    placed = window_.push(newhit, finished);
+
+  //counted, not logged; see BuildDiagnostics::report
+  if (placed.appended > 1)
+    diag_.record(BuildDiagnostics::Anomaly::multiple, newhit);
+  if (placed.pileup)
+    diag_.record(BuildDiagnostics::Anomaly::pileup, newhit);
+  if (placed.antecedent)
+    diag_.record(BuildDiagnostics::Anomaly::antecedent, newhit);
+}
+
+}
@@ -0,0 +1,91 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * This software can be redistributed and/or modified freely provided that
+ * any derivative works bear some notice that they are derived from it, and
+ * any modified versions bear some notice that they have been modified.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::CoincidenceSetup   parameters that determine how hits are
+ *                              grouped into events
+ *
+ *      Qpx::EventBuilder       time-correlates presorted hits into events.
+ *                              One builder may serve every sink that shares
+ *                              the same CoincidenceSetup.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "event.h"
+#include "coincidence_window.h"
+#include "ingest_plan.h"
+#include "build_diagnostics.h"
+#include "spill.h"
+#include "hit_batch.h"
+#include <list>
+
+namespace Qpx {
+
+struct CoincidenceSetup
+{
+  double               coinc_window {0};
+  uint16_t             bits {0};
+  std::vector<double>  delay_ns;
+  std::vector<int32_t> cutoff_logic;
+  std::vector<bool>    relevant;
+
+  inline bool is_relevant(int16_t chan) const
+  {
+    return ((chan >= 0) && (chan < static_cast<int16_t>(relevant.size())) && relevant[chan]);
+  }
+
+
+  double max_delay() const;
+
+  bool operator<(const CoincidenceSetup& other) const;
+  bool operator==(const CoincidenceSetup& other) const;
+  bool operator!=(const CoincidenceSetup& other) const {return !operator==(other);}
+};
+
+class EventBuilder
+{
+public:
+  EventBuilder() {}
+  EventBuilder(const CoincidenceSetup& setup);
+
+  const CoincidenceSetup& setup() const {return setup_;}
+
+  //finished events are appended to the list, unvalidated
+  void push_spill(const Spill&, EventBatch& finished);
+  void push_hit(const Hit&, EventBatch& finished);
+  //channel and energy are checked on the columns; a Hit is
+  //materialized only for rows that pass
+  void push_hits(const HitBatch&, EventBatch& finished);
+  void push_stats(const StatsUpdate&);
+
+  BuildDiagnostics& diagnostics() { return diag_; }
+  const BuildDiagnostics& diagnostics() const { return diag_; }
+
+private:
+  CoincidenceSetup setup_;
+  double max_delay_ {0};
+
+  IngestPlan plan_;
+  CoincidenceWindow window_;
+  BuildDiagnostics diag_;
+
+  void push_planned(const Hit&, const ChannelPlan&, EventBatch& finished);
+};
+
+}
@@ -26,8 +26,8 @@ std::string Hit::to_string() const
 {
   std::stringstream ss;
   ss << "[ch" << source_channel_ << "|t" << timestamp_.to_string();
-  for (auto &v : values_)
-    ss << v.to_string();
+  for (size_t i=0; i < value_count_; ++i)
+    ss << values_[i].to_string();
   ss << "]";
   return ss.str();
 }
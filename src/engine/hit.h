@@ -20,8 +20,10 @@
 #pragma once
 
 #include "hit_model.h"
+#include "trace_arena.h"
 #include <vector>
 #include <fstream>
+#include <cstring>
 
 #include "xmlable.h"
 
@@ -30,13 +32,21 @@ using namespace nlohmann;
 
 namespace Qpx {
 
+//fixed size, no heap allocation; traces live in a shared TraceArena,
+//so copying a hit costs at most one reference count increment
 class Hit
 {
+public:
+  static const size_t kMaxValues = QPX_HIT_MAX_VALUES;
+
 private:
   int16_t       source_channel_;
+  uint16_t      value_count_ {0};
+  uint32_t      trace_length_ {0};  //as per model
   TimeStamp     timestamp_;
-  std::vector<DigitizedVal> values_;
-  std::vector<uint16_t>     trace_;
+  DigitizedVal  values_[kMaxValues];
+  const uint16_t* trace_ {nullptr};
+  TraceArenaPtr   trace_arena_;
 
 public:
   inline Hit()
@@ -45,10 +55,12 @@ public:
 
   inline Hit(int16_t sourcechan, const HitModel &model)
     : source_channel_(sourcechan)
+    , value_count_ (std::min<size_t>(model.values.size(), QPX_HIT_MAX_VALUES))
+    , trace_length_ (model.tracelength)
     , timestamp_(model.timebase)
-    , values_ (model.values)
   {
-    trace_.resize(model.tracelength);
+    for (size_t i=0; i < value_count_; ++i)
+      values_[i] = model.values[i];
   }
 
   //Accessors
@@ -64,20 +76,26 @@ public:
 
   inline size_t value_count() const
   {
-    return values_.size();
+    return value_count_;
   }
 
   inline DigitizedVal value(size_t idx) const
   {
-    if (idx < values_.size())
-      return values_.at(idx);
+    if (idx < value_count_)
+      return values_[idx];
     else
       return DigitizedVal();
   }
 
-  inline const std::vector<uint16_t>& trace() const
+  //empty until set
+  inline TraceView trace() const
   {
-    return trace_;
+    return trace_ ? TraceView(trace_, trace_length_) : TraceView();
+  }
+
+  inline size_t trace_length() const
+  {
+    return trace_length_;
   }
 
   //Setters
@@ -88,38 +106,49 @@ public:
 
   inline void set_value(size_t idx, uint16_t val)
   {
-    if (idx < values_.size())
+    if (idx < value_count_)
       values_[idx].set_val(val);
   }
 
+  //copied into arena, truncated or zero-padded to model trace length
+  inline void set_trace(const uint16_t* data, size_t count, const TraceArenaPtr &arena)
+  {
+    if (!trace_length_ || !arena)
+      return;
+    trace_ = arena->store(data, count, trace_length_);
+    trace_arena_ = arena;
+  }
+
+  //convenience; allocates an arena of its own
   inline void set_trace(const std::vector<uint16_t> &trc)
   {
-    size_t len = std::min(trc.size(), trace_.size());
-    for (size_t i=0; i < len; ++i)
-      trace_[i] = trc.at(i);
+    if (trace_length_)
+      set_trace(trc.data(), trc.size(), std::make_shared<TraceArena>());
   }
 
   //Comparators
-  inline bool operator==(const Hit other) const
+  inline bool operator==(const Hit& other) const
   {
     if (source_channel_ != other.source_channel_) return false;
     if (timestamp_ != other.timestamp_) return false;
-    if (values_ != other.values_) return false;
-    if (trace_ != other.trace_) return false;
+    if (value_count_ != other.value_count_) return false;
+    for (size_t i=0; i < value_count_; ++i)
+      if (values_[i] != other.values_[i]) return false;
+    if (trace() != other.trace()) return false;
     return true;
   }
 
-  inline bool operator!=(const Hit other) const
+  inline bool operator!=(const Hit& other) const
   {
     return !operator==(other);
   }
 
-  inline bool operator<(const Hit other) const
+  inline bool operator<(const Hit& other) const
   {
     return (timestamp_ < other.timestamp_);
   }
 
-  inline bool operator>(const Hit other) const
+  inline bool operator>(const Hit& other) const
   {
     return (timestamp_ > other.timestamp_);
   }
@@ -129,18 +158,58 @@ public:
     timestamp_.delay(ns);
   }
 
-  //binary stream i/o
+  inline void delay_native(uint64_t ticks)
+  {
+    timestamp_.delay_native(ticks);
+  }
+
+  //binary stream i/o; trace always written at model length
   inline void write_bin(std::ofstream &outfile) const
   {
     outfile.write((char*)&source_channel_, sizeof(source_channel_));
     timestamp_.write_bin(outfile);
-    for (auto &v : values_)
-      v.write_bin(outfile);
-    if (trace_.size())
-      outfile.write((char*)trace_.data(), sizeof(uint16_t) * trace_.size());
+    for (size_t i=0; i < value_count_; ++i)
+      values_[i].write_bin(outfile);
+    if (trace_)
+      outfile.write((char*)trace_, sizeof(uint16_t) * trace_length_);
+    else if (trace_length_)
+    {
+      std::vector<uint16_t> blank(trace_length_, 0);
+      outfile.write((char*)blank.data(), sizeof(uint16_t) * trace_length_);
+    }
+  }
+
+  //bytes taken by write_bin
+  inline size_t bin_size() const
+  {
+    return sizeof(source_channel_) + sizeof(uint64_t)
+        + sizeof(uint16_t) * (value_count_ + trace_length_);
   }
 
-  inline void read_bin(std::ifstream &infile, const std::map<int16_t, HitModel> &model_hits)
+  //same layout as write_bin, into memory; returns end of what was written
+  inline char* write_bin(char* out) const
+  {
+    std::memcpy(out, &source_channel_, sizeof(source_channel_));
+    out += sizeof(source_channel_);
+    uint64_t native = timestamp_.native();
+    std::memcpy(out, &native, sizeof(native));
+    out += sizeof(native);
+    for (size_t i=0; i < value_count_; ++i)
+    {
+      uint16_t v = values_[i].native();
+      std::memcpy(out, &v, sizeof(v));
+      out += sizeof(v);
+    }
+    size_t trace_bytes = sizeof(uint16_t) * trace_length_;
+    if (trace_)
+      std::memcpy(out, trace_, trace_bytes);
+    else
+      std::memset(out, 0, trace_bytes);
+    return out + trace_bytes;
+  }
+
+  inline void read_bin(std::ifstream &infile, const std::map<int16_t, HitModel> &model_hits,
+                       TraceArenaPtr arena = nullptr)
   {
     int16_t channel = -1;
     infile.read(reinterpret_cast<char*>(&channel), sizeof(channel));
@@ -149,14 +218,71 @@ public:
     *this = Hit(channel, model_hits.at(channel));
     timestamp_.read_bin(infile);
 
-    for (auto &v : values_)
-      v.read_bin(infile);
+    for (size_t i=0; i < value_count_; ++i)
+      values_[i].read_bin(infile);
+
+    if (trace_length_)
+    {
+      if (!arena)
+        arena = std::make_shared<TraceArena>();
+      uint16_t* trc = arena->allocate(trace_length_);
+      infile.read(reinterpret_cast<char*>(trc), sizeof(uint16_t) * trace_length_);
+      trace_ = trc;
+      trace_arena_ = arena;
+    }
+  }
+
+  //decodes write_bin layout from memory; nullptr if truncated or channel
+  //has no model. Traces point into the source if aligned, so arena must
+  //hold that memory (TraceArena::hold); otherwise they are copied.
+  inline const char* read_bin(const char* in, const char* end,
+                              const std::map<int16_t, HitModel> &model_hits,
+                              const TraceArenaPtr &arena)
+  {
+    int16_t channel = -1;
+    if (end - in < static_cast<ptrdiff_t>(sizeof(channel)))
+      return nullptr;
+    std::memcpy(&channel, in, sizeof(channel));
+    auto model = model_hits.find(channel);
+    if (model == model_hits.end())
+      return nullptr;
+    *this = Hit(channel, model->second);
+    if (end - in < static_cast<ptrdiff_t>(bin_size()))
+      return nullptr;
+    in += sizeof(channel);
 
-    if (trace_.size())
-      infile.read(reinterpret_cast<char*>(trace_.data()), sizeof(uint16_t) * trace_.size());
+    uint64_t native;
+    std::memcpy(&native, in, sizeof(native));
+    timestamp_ = timestamp_.make(native);
+    in += sizeof(native);
+
+    for (size_t i=0; i < value_count_; ++i)
+    {
+      uint16_t v;
+      std::memcpy(&v, in, sizeof(v));
+      values_[i].set_val(v);
+      in += sizeof(v);
+    }
+
+    if (trace_length_)
+    {
+      if (reinterpret_cast<uintptr_t>(in) % alignof(uint16_t))
+      {
+        uint16_t* trc = arena->allocate(trace_length_);
+        std::memcpy(trc, in, sizeof(uint16_t) * trace_length_);
+        trace_ = trc;
+      }
+      else
+        trace_ = reinterpret_cast<const uint16_t*>(in);
+      trace_arena_ = arena;
+      in += sizeof(uint16_t) * trace_length_;
+    }
+    return in;
   }
 
   std::string to_string() const;
+
+  friend class HitBatch;
 };
 
 }
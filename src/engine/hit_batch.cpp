@@ -0,0 +1,194 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::HitBatch  hits of one spill in parallel arrays
+ *
+ ******************************************************************************/
+
+#include "hit_batch.h"
+
+namespace Qpx {
+
+void HitBatch::clear()
+{
+  head_ = 0;
+  value_width_ = 0;
+  channels_.clear();
+  kind_.clear();
+  time_native_.clear();
+  for (auto &v : values_)
+    v.clear();
+  trace_refs_.clear();
+  kinds_.clear();
+  traces_.clear();
+  arenas_.clear();
+  channel_kinds_.clear();
+}
+
+void HitBatch::reserve(size_t n)
+{
+  n += head_;
+  channels_.reserve(n);
+  kind_.reserve(n);
+  time_native_.reserve(n);
+  for (size_t i=0; i < value_width_; ++i)
+    values_[i].reserve(n);
+}
+
+void HitBatch::widen(uint16_t width)
+{
+  //new columns are zero for rows already present
+  for (size_t i=value_width_; i < width; ++i)
+  {
+    values_[i].reserve(channels_.capacity());
+    values_[i].resize(channels_.size(), 0);
+  }
+  value_width_ = width;
+}
+
+uint16_t HitBatch::find_kind(const Hit& hit)
+{
+  auto same = [&hit](const Hit& k) {
+    if ((k.source_channel_ != hit.source_channel_) ||
+        !k.timestamp_.same_base(hit.timestamp_) ||
+        (k.value_count_ != hit.value_count_) ||
+        (k.trace_length_ != hit.trace_length_))
+      return false;
+    for (size_t i=0; i < k.value_count_; ++i)
+      if (k.values_[i].bits() != hit.values_[i].bits())
+        return false;
+    return true;
+  };
+
+  int16_t chan = hit.source_channel_;
+  bool cached = (chan >= 0);
+  if (cached && (static_cast<size_t>(chan) < channel_kinds_.size()) && channel_kinds_[chan])
+  {
+    uint16_t k = channel_kinds_[chan] - 1;
+    if (same(kinds_[k]))
+      return k;
+  }
+
+  size_t k = 0;
+  while ((k < kinds_.size()) && !same(kinds_[k]))
+    ++k;
+
+  if (k == kinds_.size())
+  {
+    Hit proto(hit.source_channel_, HitModel());
+    proto.timestamp_ = hit.timestamp_.make(0);
+    proto.value_count_ = hit.value_count_;
+    for (size_t i=0; i < hit.value_count_; ++i)
+      proto.values_[i] = DigitizedVal(0, hit.values_[i].bits());
+    proto.trace_length_ = hit.trace_length_;
+    kinds_.push_back(proto);
+  }
+
+  if (cached)
+  {
+    if (static_cast<size_t>(chan) >= channel_kinds_.size())
+      channel_kinds_.resize(chan + 1, 0);
+    channel_kinds_[chan] = k + 1;
+  }
+  return k;
+}
+
+uint32_t HitBatch::find_arena(const TraceArenaPtr& arena)
+{
+  for (size_t i=arenas_.size(); i > 0; --i)
+    if (arenas_[i-1] == arena)
+      return i-1;
+  arenas_.push_back(arena);
+  return arenas_.size() - 1;
+}
+
+void HitBatch::add_trace(size_t row, const uint16_t* data, const TraceArenaPtr& arena)
+{
+  if (trace_refs_.size() < channels_.size())
+    trace_refs_.resize(channels_.size(), kNoTrace);
+  TraceRef ref;
+  ref.data = data;
+  ref.arena = find_arena(arena);
+  trace_refs_[row] = traces_.size();
+  traces_.push_back(ref);
+}
+
+void HitBatch::push_back(const Hit& hit)
+{
+  uint16_t k = find_kind(hit);
+  if (hit.value_count_ > value_width_)
+    widen(hit.value_count_);
+
+  size_t row = channels_.size();
+  channels_.push_back(hit.source_channel_);
+  kind_.push_back(k);
+  time_native_.push_back(hit.timestamp_.native());
+  for (size_t i=0; i < value_width_; ++i)
+    values_[i].push_back((i < hit.value_count_) ? hit.values_[i].val(hit.values_[i].bits()) : 0);
+
+  if (!trace_refs_.empty())
+    trace_refs_.push_back(kNoTrace);
+  if (hit.trace_)
+    add_trace(row, hit.trace_, hit.trace_arena_);
+}
+
+void HitBatch::append(const HitBatch& other, size_t i)
+{
+  size_t src = other.head_ + i;
+  uint16_t k = find_kind(other.kinds_[other.kind_[src]]);
+  if (other.value_width_ > value_width_)
+    widen(other.value_width_);
+
+  size_t row = channels_.size();
+  channels_.push_back(other.channels_[src]);
+  kind_.push_back(k);
+  time_native_.push_back(other.time_native_[src]);
+  for (size_t j=0; j < value_width_; ++j)
+    values_[j].push_back((j < other.value_width_) ? other.values_[j][src] : 0);
+
+  if (!trace_refs_.empty())
+    trace_refs_.push_back(kNoTrace);
+  if (!other.trace_refs_.empty() && (other.trace_refs_[src] != kNoTrace))
+  {
+    const TraceRef& ref = other.traces_[other.trace_refs_[src]];
+    add_trace(row, ref.data, other.arenas_[ref.arena]);
+  }
+}
+
+void HitBatch::pop_front()
+{
+  if (empty())
+    return;
+  head_++;
+  if (empty())
+    clear();
+}
+
+Hit HitBatch::at(size_t i) const
+{
+  size_t r = head_ + i;
+  Hit ret = kinds_[kind_[r]];
+  ret.timestamp_ = ret.timestamp_.make(time_native_[r]);
+  for (size_t j=0; j < ret.value_count_; ++j)
+    ret.values_[j].set_val(values_[j][r]);
+  if (!trace_refs_.empty() && (trace_refs_[r] != kNoTrace))
+  {
+    const TraceRef& ref = traces_[trace_refs_[r]];
+    ret.trace_ = ref.data;
+    ret.trace_arena_ = arenas_[ref.arena];
+  }
+  return ret;
+}
+
+}
@@ -0,0 +1,143 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::HitBatch  hits of one spill in parallel arrays: channel,
+ *                     native timestamp and one column per value index.
+ *                     Timebase, value bits and trace length are shared
+ *                     by all hits of a kind and kept once per kind.
+ *                     Traces, if any, are referenced through a table
+ *                     into the arenas that hold them.
+ *
+ *                     Reads as a container of Hits (materialized on
+ *                     access) or column by column; EventBuilder checks
+ *                     channel and energy on the columns and only
+ *                     materializes hits that pass.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "hit.h"
+#include <iterator>
+
+namespace Qpx {
+
+class HitBatch
+{
+public:
+  class const_iterator
+  {
+  public:
+    typedef std::input_iterator_tag iterator_category;
+    typedef Hit                      value_type;
+    typedef std::ptrdiff_t           difference_type;
+    typedef const Hit*               pointer;
+    typedef Hit                      reference;
+
+    const_iterator(const HitBatch* batch, size_t i) : batch_(batch), i_(i) {}
+
+    inline Hit operator*() const { return batch_->at(i_); }
+    inline const_iterator& operator++() { ++i_; return *this; }
+    inline const_iterator operator++(int) { const_iterator ret = *this; ++i_; return ret; }
+    inline bool operator==(const const_iterator& o) const { return (i_ == o.i_); }
+    inline bool operator!=(const const_iterator& o) const { return (i_ != o.i_); }
+    inline difference_type operator-(const const_iterator& o) const { return i_ - o.i_; }
+
+  private:
+    const HitBatch* batch_;
+    size_t i_;
+  };
+
+  HitBatch() {}
+
+  //rows consumed by pop_front are not counted
+  inline size_t size() const { return channels_.size() - head_; }
+  inline bool empty() const { return (head_ >= channels_.size()); }
+
+  void clear();
+  void reserve(size_t n);
+
+  void push_back(const Hit& hit);
+
+  //copies row i of other
+  void append(const HitBatch& other, size_t i);
+
+  //O(1); storage is released once the batch is drained
+  void pop_front();
+
+  Hit at(size_t i) const;
+  inline Hit operator[](size_t i) const { return at(i); }
+  inline Hit front() const { return at(0); }
+
+  inline TimeStamp timestamp(size_t i) const
+  {
+    size_t r = head_ + i;
+    return kinds_[kind_[r]].timestamp().make(time_native_[r]);
+  }
+
+  inline int16_t channel(size_t i) const { return channels_[head_ + i]; }
+
+  inline const_iterator begin() const { return const_iterator(this, 0); }
+  inline const_iterator end() const { return const_iterator(this, size()); }
+
+  //columns over size() rows
+  inline const int16_t*  channels() const { return channels_.data() + head_; }
+  inline const uint16_t* kinds() const { return kind_.data() + head_; }
+  inline const uint64_t* timestamps_native() const { return time_native_.data() + head_; }
+
+  //nullptr if no hit in batch has a value at idx
+  inline const uint16_t* values(size_t idx) const
+  {
+    return (idx < value_width_) ? values_[idx].data() + head_ : nullptr;
+  }
+
+  //prototype of a kind: channel, timebase, value bits, trace length
+  inline const Hit& kind(uint16_t k) const { return kinds_[k]; }
+  inline size_t kind_count() const { return kinds_.size(); }
+
+  inline bool has_traces() const { return !trace_refs_.empty(); }
+
+private:
+  static const uint32_t kNoTrace = UINT32_MAX;
+
+  struct TraceRef
+  {
+    const uint16_t* data;
+    uint32_t arena;
+  };
+
+  size_t head_ {0};
+  uint16_t value_width_ {0};
+
+  //rows
+  std::vector<int16_t>  channels_;
+  std::vector<uint16_t> kind_;
+  std::vector<uint64_t> time_native_;
+  std::vector<uint16_t> values_[Hit::kMaxValues];
+  std::vector<uint32_t> trace_refs_;  //empty until a traced hit arrives
+
+  //shared
+  std::vector<Hit>           kinds_;
+  std::vector<TraceRef>      traces_;
+  std::vector<TraceArenaPtr> arenas_;
+  std::vector<uint16_t>      channel_kinds_;  //last kind + 1 by channel, 0 if none
+
+  //checks the channel's last kind first; full scan only when it changed
+  uint16_t find_kind(const Hit& hit);
+  uint32_t find_arena(const TraceArenaPtr& arena);
+  void add_trace(size_t row, const uint16_t* data, const TraceArenaPtr& arena);
+  void widen(uint16_t width);
+};
+
+}
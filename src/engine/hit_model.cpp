@@ -18,12 +18,16 @@
  ******************************************************************************/
 
 #include "hit_model.h"
+#include "custom_logger.h"
 #include <sstream>
 
 namespace Qpx {
 
 void HitModel::add_value(const std::string& name, uint16_t bits)
 {
+  if (values.size() >= QPX_HIT_MAX_VALUES)
+    WARN << "<HitModel> value " << name << " exceeds hit capacity of "
+         << QPX_HIT_MAX_VALUES << ", will not be recorded";
   values.push_back(DigitizedVal(0,bits));
   idx_to_name.push_back(name);
   name_to_idx[name] = values.size() - 1;
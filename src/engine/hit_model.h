@@ -29,6 +29,11 @@
 #include "json.hpp"
 using namespace nlohmann;
 
+//values held inline by each hit; models with more are truncated
+#ifndef QPX_HIT_MAX_VALUES
+#define QPX_HIT_MAX_VALUES 8
+#endif
+
 namespace Qpx {
 
 struct HitModel
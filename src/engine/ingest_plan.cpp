@@ -0,0 +1,68 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::IngestPlan  per-channel constants for the hit path
+ *
+ ******************************************************************************/
+
+#include "ingest_plan.h"
+#include <cmath>
+
+namespace Qpx {
+
+void IngestPlan::compile(int16_t chan, const HitModel& model, uint16_t bits,
+                         int32_t cutoff, double delay_ns, bool relevant)
+{
+  if (chan < 0)
+    return;
+  if (chan >= static_cast<int16_t>(plans_.size()))
+    plans_.resize(chan + 1);
+
+  ChannelPlan plan;
+  plan.planned = true;
+  plan.relevant = relevant;
+
+  uint16_t native_bits = bits;
+  if (model.name_to_idx.count("energy"))
+  {
+    size_t idx = model.name_to_idx.at("energy");
+    if (idx < Hit::kMaxValues)
+    {
+      plan.value_idx = idx;
+      native_bits = model.values.at(idx).bits();
+    }
+  }
+  plan.shift = native_bits - bits;
+
+  //same outcome as comparing DigitizedVal::val(bits) against cutoff
+  if (cutoff > 0)
+  {
+    if (plan.shift >= 0)
+      plan.cutoff_native = static_cast<uint32_t>(cutoff) << plan.shift;
+    else
+    {
+      uint32_t step = 1 << (-plan.shift);
+      plan.cutoff_native = (static_cast<uint32_t>(cutoff) + step - 1) / step;
+    }
+  }
+
+  //same rounding as TimeStamp::delay
+  if (delay_ns > 0)
+    plan.delay_native = std::ceil(delay_ns * model.timebase.timebase_divider()
+                                  / model.timebase.timebase_multiplier());
+
+  plans_[chan] = plan;
+}
+
+}
@@ -0,0 +1,76 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::IngestPlan  per-channel constants for the hit path, compiled
+ *                       once from the channel's hit model: where energy
+ *                       is, how to scale it, cutoff and delay in native
+ *                       units, and whether the channel matters at all.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "hit.h"
+
+namespace Qpx {
+
+struct ChannelPlan
+{
+  bool     planned  {false};
+  bool     relevant {false};
+  int16_t  value_idx {-1};     //energy
+  int16_t  shift {0};          //native bits - target bits
+  uint32_t cutoff_native {0};  //native energy below this is dropped
+  uint64_t delay_native {0};   //in channel's own ticks
+
+  //energy at target resolution
+  inline uint16_t value(const Hit& h) const
+  {
+    uint16_t raw = h.value(value_idx).native();
+    return (shift >= 0) ? (raw >> shift) : static_cast<uint16_t>(raw << -shift);
+  }
+
+  inline bool passes(const Hit& h) const
+  {
+    return passes(h.value(value_idx).native());
+  }
+
+  //same, on a value column as in HitBatch::values(value_idx)
+  inline bool passes(uint16_t native) const
+  {
+    return (native >= cutoff_native);
+  }
+};
+
+class IngestPlan
+{
+public:
+  inline void clear() { plans_.clear(); }
+
+  void compile(int16_t chan, const HitModel& model, uint16_t bits,
+               int32_t cutoff, double delay_ns, bool relevant);
+
+  //nullptr until channel has been compiled
+  inline const ChannelPlan* find(int16_t chan) const
+  {
+    if ((chan < 0) || (chan >= static_cast<int16_t>(plans_.size())) || !plans_[chan].planned)
+      return nullptr;
+    return &plans_[chan];
+  }
+
+private:
+  std::vector<ChannelPlan> plans_;
+};
+
+}
@@ -0,0 +1,304 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::ListIndex  spill index for list mode output
+ *
+ ******************************************************************************/
+
+#include "list_index.h"
+#include "custom_logger.h"
+#include <boost/filesystem.hpp>
+
+namespace Qpx {
+
+const std::string ListIndexWriter::file_name = "qpx_out.idx";
+
+static const std::string kFormat = "QpxListIndex";
+static const int kVersion = 1;
+
+bool ListIndexWriter::open(const std::string& path, const Setting& attributes)
+{
+  close();
+
+  path_ = path;
+  file_.open(path_, std::ofstream::out | std::ofstream::trunc);
+  if (!file_.is_open() || !file_.good())
+  {
+    ERR << "<ListIndexWriter> Could not open " << path_;
+    file_.close();
+    return false;
+  }
+
+  json header;
+  header["type"] = "header";
+  header["format"] = kFormat;
+  header["version"] = kVersion;
+  header["attributes"] = attributes;
+  write(header);
+  return true;
+}
+
+void ListIndexWriter::append(const Spill& spill, uint64_t offset,
+                             uint64_t bytes, uint64_t hit_count)
+{
+  if (!file_.is_open())
+    return;
+
+  json record;
+  to_json(record, spill, false);
+  record["type"] = "spill";
+  record["offset"] = offset;
+  record["bytes"] = bytes;
+  record["hits"] = hit_count;
+
+  if (!spill.state.branches.empty() || !spill.detectors.empty())
+  {
+    json snapshot;
+    if (!spill.state.branches.empty())
+      snapshot["state"] = spill.state;
+    if (!spill.detectors.empty())
+      snapshot["detectors"] = spill.detectors;
+
+    std::string key = snapshot.dump();
+    auto it = snapshots_.find(key);
+    if (it == snapshots_.end())
+    {
+      it = snapshots_.insert(std::make_pair(key, snapshots_.size())).first;
+      snapshot["type"] = "settings";
+      snapshot["id"] = it->second;
+      write(snapshot);
+    }
+    record["settings"] = it->second;
+  }
+
+  pending_.push_back(Pending{offset + bytes, hit_count, record});
+}
+
+void ListIndexWriter::commit(uint64_t written)
+{
+  while (!pending_.empty() && (pending_.front().end <= written))
+  {
+    write(pending_.front().record);
+    spills_++;
+    hits_ += pending_.front().hit_count;
+    bytes_ = pending_.front().end;
+    pending_.pop_front();
+  }
+}
+
+void ListIndexWriter::close()
+{
+  if (!file_.is_open())
+    return;
+
+  if (!pending_.empty())
+    WARN << "<ListIndexWriter> " << pending_.size()
+         << " spills were never written to the binary, dropped from " << path_;
+  pending_.clear();
+
+  json footer;
+  footer["type"] = "footer";
+  footer["spills"] = spills_;
+  footer["hits"] = hits_;
+  footer["bytes"] = bytes_;
+  footer["settings"] = snapshots_.size();
+  write(footer);
+
+  file_.close();
+  snapshots_.clear();
+  spills_ = hits_ = bytes_ = 0;
+}
+
+void ListIndexWriter::write(const json& record)
+{
+  file_ << record.dump() << "\n";
+  file_.flush();
+  if (!file_.good())
+    ERR << "<ListIndexWriter> Write to " << path_ << " failed";
+}
+
+
+void ListIndex::clear()
+{
+  attributes = Setting();
+  spills.clear();
+  bin_path.clear();
+  complete = false;
+}
+
+bool ListIndex::load(const std::string& path)
+{
+  clear();
+
+  std::ifstream file(path);
+  if (!file.is_open())
+  {
+    WARN << "<ListIndex> Could not open " << path;
+    return false;
+  }
+
+  boost::filesystem::path bin(path);
+  bin.make_preferred();
+  bin = bin.remove_filename() / "qpx_out.bin";
+  bin_path = bin.string();
+
+  bool ok;
+  if (file.peek() == '{')
+    ok = load_index(file, path);
+  else
+  {
+    file.close();
+    ok = load_xml(path);
+  }
+
+  if (!ok)
+    return false;
+
+  //spills are indexed only once written, but a legacy index or a binary
+  //truncated after the fact may still point past the end
+  boost::system::error_code ec;
+  uint64_t bin_size = boost::filesystem::file_size(bin, ec);
+  if (ec)
+  {
+    WARN << "<ListIndex> Could not open binary " << bin_path;
+    return false;
+  }
+  size_t valid = spills.size();
+  while (valid && (spills[valid-1].offset + spills[valid-1].bytes > bin_size))
+    valid--;
+  if (valid < spills.size())
+  {
+    WARN << "<ListIndex> " << (spills.size() - valid)
+         << " trailing spills are beyond the end of " << bin_path;
+    spills.resize(valid);
+  }
+
+  return !spills.empty();
+}
+
+bool ListIndex::load_index(std::ifstream& file, const std::string& path)
+{
+  std::map<size_t, Spill> snapshots;
+  std::string line;
+  size_t line_number = 0;
+  bool header = false;
+
+  while (std::getline(file, line))
+  {
+    line_number++;
+    if (line.empty())
+      continue;
+
+    json record;
+    try { record = json::parse(line); }
+    catch (...)
+    {
+      //only the last line can be torn by a crash
+      WARN << "<ListIndex> Unreadable record at line " << line_number
+           << " of " << path << ", stopping there";
+      break;
+    }
+
+    std::string type = record.count("type") ? record["type"].get<std::string>() : "";
+    if (type == "header")
+    {
+      if (!record.count("format") || (record["format"].get<std::string>() != kFormat))
+        break;
+      if (record.count("attributes"))
+        attributes = record["attributes"];
+      header = true;
+    }
+    else if (!header)
+      break;
+    else if (type == "settings")
+    {
+      Spill snapshot;
+      if (record.count("state"))
+        snapshot.state = record["state"];
+      if (record.count("detectors"))
+        for (auto it : record["detectors"])
+          snapshot.detectors.push_back(it);
+      snapshots[record["id"].get<size_t>()] = snapshot;
+    }
+    else if (type == "spill")
+    {
+      ListSpill ls;
+      from_json(record, ls.spill);
+      ls.offset    = record["offset"].get<uint64_t>();
+      ls.bytes     = record["bytes"].get<uint64_t>();
+      ls.hit_count = record["hits"].get<uint64_t>();
+      if (record.count("settings"))
+      {
+        size_t id = record["settings"].get<size_t>();
+        if (snapshots.count(id))
+        {
+          ls.spill.state = snapshots.at(id).state;
+          ls.spill.detectors = snapshots.at(id).detectors;
+        }
+      }
+      spills.push_back(ls);
+    }
+    else if (type == "footer")
+      complete = true;
+  }
+
+  if (!header)
+  {
+    WARN << "<ListIndex> Bad header in " << path;
+    return false;
+  }
+
+  if (!complete)
+    WARN << "<ListIndex> No footer in " << path
+         << "; run did not finish cleanly, recovered " << spills.size() << " spills";
+
+  return true;
+}
+
+bool ListIndex::load_xml(const std::string& path)
+{
+  pugi::xml_document doc;
+
+  if (!doc.load_file(path.c_str())) {
+    WARN << "<ListIndex> Could not parse XML in " << path;
+    return false;
+  }
+
+  pugi::xml_node root = doc.first_child();
+  if (!root || (std::string(root.name()) != "QpxListData")) {
+    WARN << "<ListIndex> Bad root ID in " << path;
+    return false;
+  }
+
+  if (root.child(attributes.xml_element_name().c_str()))
+    attributes.from_xml(root.child(attributes.xml_element_name().c_str()));
+
+  for (pugi::xml_node child : root.children()) {
+    std::string name = std::string(child.name());
+    if (name == Qpx::Spill().xml_element_name()) {
+      ListSpill ls;
+      ls.spill.from_xml(child);
+      if (ls.spill != Qpx::Spill()) {
+        ls.hit_count = child.attribute("raw_hit_count").as_ullong(0);
+        ls.offset = child.attribute("file_offset").as_ullong(0);
+        spills.push_back(ls);
+      }
+    }
+  }
+
+  complete = true;
+  return true;
+}
+
+}
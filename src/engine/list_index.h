@@ -0,0 +1,111 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::ListIndexWriter  spill index for list mode output, written as
+ *                            it goes, one JSON record per line:
+ *                              header    sink attributes
+ *                              settings  state and detectors, each distinct
+ *                                        snapshot written once, with an id
+ *                              spill     time, stats, file offset, bytes,
+ *                                        hit count, settings id if any
+ *                              footer    totals, written on close
+ *                            A spill record is held back until its hits are
+ *                            written to the binary (commit), so whatever is
+ *                            in the index survives a crash, even if the
+ *                            binary was preallocated past its data.
+ *
+ *      Qpx::ListIndex        reads the above, or the legacy qpx_out.xml
+ *                            with whole spills in a pugixml document
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <deque>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "spill.h"
+
+namespace Qpx {
+
+struct ListSpill
+{
+  Spill    spill;         //without hits; state and detectors as recorded
+  uint64_t hit_count {0};
+  uint64_t offset    {0};  //in binary file
+  uint64_t bytes     {0};  //0 if unknown (legacy index)
+};
+
+class ListIndexWriter
+{
+public:
+  static const std::string file_name;  //qpx_out.idx
+
+  ~ListIndexWriter() { close(); }
+
+  bool open(const std::string& path, const Setting& attributes);
+  bool is_open() const { return file_.is_open(); }
+
+  //spill hits are ignored; record is held until commit covers its bytes
+  void append(const Spill& spill, uint64_t offset, uint64_t bytes, uint64_t hit_count);
+
+  //writes and flushes held records that end at or before written
+  void commit(uint64_t written);
+
+  //held records not committed by now are dropped
+  void close();
+
+private:
+  std::ofstream file_;
+  std::string   path_;
+  uint64_t spills_ {0};
+  uint64_t hits_   {0};
+  uint64_t bytes_  {0};
+
+  //serialized snapshot to id; distinct snapshots are few
+  std::map<std::string, size_t> snapshots_;
+
+  struct Pending
+  {
+    uint64_t end;
+    uint64_t hit_count;
+    json     record;
+  };
+  std::deque<Pending> pending_;
+
+  void write(const json& record);
+};
+
+class ListIndex
+{
+public:
+  Setting  attributes;
+  std::vector<ListSpill> spills;
+  std::string bin_path;
+  bool complete {false};  //footer present, or legacy index
+
+  //index or legacy xml; binary is expected next to it as qpx_out.bin
+  bool load(const std::string& path);
+
+  void clear();
+
+private:
+  bool load_index(std::ifstream& file, const std::string& path);
+  bool load_xml(const std::string& path);
+};
+
+}
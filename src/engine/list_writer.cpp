@@ -0,0 +1,280 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::ListWriter  buffered list mode output
+ *
+ ******************************************************************************/
+
+#include "list_writer.h"
+#include "custom_logger.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace Qpx {
+
+//O_DIRECT needs buffer addresses, sizes and file offsets on this boundary
+static const size_t kAlign = 4096;
+
+static size_t align_up(size_t n)
+{
+  return (n + kAlign - 1) / kAlign * kAlign;
+}
+
+bool ListWriter::open(const std::string& path, const Options& options,
+                      const std::string& metrics_name)
+{
+  close();
+
+  options_ = options;
+  options_.buffer_size = align_up(std::max<size_t>(options_.buffer_size, kAlign));
+  options_.buffers = std::max<size_t>(options_.buffers, 2);
+  path_ = path;
+  written_.store(0);
+
+  int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef __linux__
+  if (options_.direct)
+  {
+    fd_ = ::open(path_.c_str(), flags | O_DIRECT, 0644);
+    if (fd_ < 0)
+      WARN << "<ListWriter> Direct I/O unavailable for " << path_
+           << " (" << std::strerror(errno) << "), using page cache";
+  }
+#else
+  options_.direct = false;
+#endif
+  if (fd_ < 0)
+  {
+    options_.direct = false;
+    fd_ = ::open(path_.c_str(), flags, 0644);
+  }
+  if (fd_ < 0)
+  {
+    ERR << "<ListWriter> Could not open " << path_ << ": " << std::strerror(errno);
+    return false;
+  }
+
+#ifdef __linux__
+  if (options_.preallocate && (::fallocate(fd_, 0, 0, options_.preallocate) != 0))
+    WARN << "<ListWriter> Could not preallocate " << options_.preallocate
+         << " bytes for " << path_ << ": " << std::strerror(errno);
+#endif
+
+  stage_ = PipelineMetrics::get().stage(Stage::write + metrics_name);
+  thread_ = boost::thread(boost::bind(&ListWriter::run, this));
+  return true;
+}
+
+bool ListWriter::failed() const
+{
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  return failed_;
+}
+
+void ListWriter::close()
+{
+  if (fd_ < 0)
+    return;
+
+  Buffer* last = current_;
+  current_ = nullptr;
+
+  {
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+  thread_.join();
+
+  //remainder is unaligned, so it goes through the page cache
+  if (last && last->size && !failed_)
+  {
+#ifdef __linux__
+    if (options_.direct)
+      ::fcntl(fd_, F_SETFL, ::fcntl(fd_, F_GETFL) & ~O_DIRECT);
+#endif
+    auto start = std::chrono::steady_clock::now();
+    write_out(last->data, last->size);
+    busy_s_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  if (last)
+    release(last);
+
+  //drop whatever was preallocated and not used
+  if (!failed_ && (::ftruncate(fd_, file_offset_) != 0))
+    WARN << "<ListWriter> Could not trim " << path_ << ": " << std::strerror(errno);
+  ::close(fd_);
+  fd_ = -1;
+
+  DBG << "<ListWriter> " << path_ << ": " << file_offset_ << " bytes in "
+      << busy_s_ << " s of I/O ("
+      << ((busy_s_ > 0) ? (file_offset_ / busy_s_ / 1048576.0) : 0) << " MB/s)";
+
+  for (auto &b : free_)
+    release(b);
+  free_.clear();
+  allocated_ = 0;
+  position_ = 0;
+  file_offset_ = 0;
+  busy_s_ = 0;
+  stop_ = false;
+  failed_ = false;
+  stage_ = nullptr;
+}
+
+void ListWriter::next_buffer(size_t min_size)
+{
+  Buffer* prev = current_;
+  Buffer* next = nullptr;
+  current_ = nullptr;
+
+  {
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    while (free_.empty() && (allocated_ >= options_.buffers))
+      cond_.wait(lock);
+    if (!free_.empty())
+    {
+      next = free_.front();
+      free_.pop_front();
+    }
+    else
+      allocated_++;
+  }
+
+  //room for a carried-over tail plus the hit that did not fit
+  size_t needed = std::max(options_.buffer_size, align_up(min_size + kAlign));
+  if (next && (next->capacity < needed))
+  {
+    release(next);
+    next = nullptr;
+  }
+  if (!next)
+    next = allocate(needed);
+  next->size = 0;
+
+  if (!prev)
+  {
+    current_ = next;
+    return;
+  }
+
+  //direct writes must be whole blocks; the rest starts the next buffer
+  if (options_.direct)
+  {
+    size_t tail = prev->size % kAlign;
+    if (tail)
+    {
+      std::memcpy(next->data, prev->data + prev->size - tail, tail);
+      prev->size -= tail;
+      next->size = tail;
+    }
+  }
+  current_ = next;
+
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  if (prev->size)
+  {
+    queued_.push_back(prev);
+    stage_->depth(queued_.size());
+  }
+  else
+    free_.push_back(prev);
+  cond_.notify_all();
+}
+
+ListWriter::Buffer* ListWriter::allocate(size_t capacity)
+{
+  Buffer* ret = new Buffer;
+  void* mem = nullptr;
+  if (posix_memalign(&mem, kAlign, capacity) != 0)
+    throw std::bad_alloc();
+  ret->data = static_cast<char*>(mem);
+  ret->capacity = capacity;
+  return ret;
+}
+
+void ListWriter::release(Buffer* buffer)
+{
+  std::free(buffer->data);
+  delete buffer;
+}
+
+void ListWriter::run()
+{
+  while (true)
+  {
+    Buffer* buffer = nullptr;
+    bool skip = false;
+    {
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      while (queued_.empty() && !stop_)
+        cond_.wait(lock);
+      if (queued_.empty())
+        return;
+      buffer = queued_.front();
+      queued_.pop_front();
+      skip = failed_;
+    }
+
+    if (!skip)
+    {
+      auto start = std::chrono::steady_clock::now();
+      StageTimer timer(stage_);
+      timer.items(buffer->size);
+      write_out(buffer->data, buffer->size);
+      timer.stop();
+      busy_s_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    {
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      buffer->size = 0;
+      free_.push_back(buffer);
+      stage_->depth(queued_.size());
+    }
+    cond_.notify_all();
+  }
+}
+
+bool ListWriter::write_out(const char* data, size_t size)
+{
+  size_t done = 0;
+  while (done < size)
+  {
+    ssize_t n = ::pwrite(fd_, data + done, size - done, file_offset_ + done);
+    if ((n < 0) && (errno == EINTR))
+      continue;
+    if (n <= 0)
+    {
+      ERR << "<ListWriter> Write to " << path_ << " failed at offset "
+          << (file_offset_ + done) << ": " << std::strerror(errno)
+          << "; further list output is discarded";
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      failed_ = true;
+      return false;
+    }
+    done += n;
+  }
+  file_offset_ += size;
+  written_.store(file_offset_);
+  return true;
+}
+
+}
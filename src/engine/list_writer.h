@@ -0,0 +1,115 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::ListWriter  buffered list mode output. Hits are serialized into
+ *                       large aligned buffers on the calling thread; full
+ *                       buffers are written out by a dedicated I/O thread.
+ *                       Bytes written and buffers queued are reported as a
+ *                       pipeline stage.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <deque>
+#include <string>
+#include <boost/thread.hpp>
+#include <boost/atomic.hpp>
+
+#include "hit.h"
+#include "pipeline_metrics.h"
+
+namespace Qpx {
+
+class ListWriter
+{
+public:
+  struct Options
+  {
+    size_t   buffer_size {4 << 20};
+    size_t   buffers     {4};      //in flight, including the one being filled
+    uint64_t preallocate {0};      //bytes reserved at open (Linux only)
+    bool     direct      {false};  //bypass page cache (Linux only)
+  };
+
+  ListWriter() {}
+  ~ListWriter() { close(); }
+
+  //metrics_name identifies the "write" stage, e.g. by sink name
+  bool open(const std::string& path, const Options& options,
+            const std::string& metrics_name);
+
+  //drains queued buffers and closes; file is trimmed to what was written
+  void close();
+
+  bool is_open() const { return fd_ >= 0; }
+  bool failed() const;
+
+  //bytes accepted so far, i.e. file offset of the next hit
+  uint64_t position() const { return position_; }
+
+  //bytes the I/O thread has handed to the OS, so a crash of this process
+  //cannot lose them; lags position() by up to the buffers in flight.
+  //Kept after close, until the next open.
+  uint64_t written() const { return written_.load(); }
+
+  inline void write(const Hit& hit)
+  {
+    size_t size = hit.bin_size();
+    if (!current_ || (current_->size + size > current_->capacity))
+      next_buffer(size);
+    current_->size = hit.write_bin(current_->data + current_->size) - current_->data;
+    position_ += size;
+  }
+
+private:
+  struct Buffer
+  {
+    char*  data     {nullptr};
+    size_t capacity {0};
+    size_t size     {0};
+  };
+
+  Options options_;
+  std::string path_;
+  int fd_ {-1};
+  uint64_t position_ {0};
+  Buffer* current_ {nullptr};
+  StageMetrics* stage_ {nullptr};
+
+  mutable boost::mutex mutex_;
+  boost::condition_variable cond_;
+  std::deque<Buffer*> queued_;
+  std::deque<Buffer*> free_;
+  size_t allocated_ {0};
+  bool stop_ {false};
+  bool failed_ {false};
+  uint64_t file_offset_ {0};  //I/O thread only until joined
+  boost::atomic<uint64_t> written_ {0};
+  double   busy_s_ {0};
+  boost::thread thread_;
+
+  ListWriter(const ListWriter&);
+  void operator=(const ListWriter&);
+
+  //submits current buffer, if any, and takes a free one that fits at least min_size
+  void next_buffer(size_t min_size);
+
+  Buffer* allocate(size_t capacity);
+  void release(Buffer* buffer);
+  void run();
+  bool write_out(const char* data, size_t size);
+};
+
+}
@@ -0,0 +1,100 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::MappedFile  read-only memory map of a whole file
+ *
+ ******************************************************************************/
+
+#include "mapped_file.h"
+#include "custom_logger.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace Qpx {
+
+bool MappedFile::open(const std::string& path)
+{
+  close();
+
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    WARN << "<MappedFile> Could not open " << path << ": " << std::strerror(errno);
+    return false;
+  }
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0)
+  {
+    WARN << "<MappedFile> Could not stat " << path << ": " << std::strerror(errno);
+    ::close(fd);
+    return false;
+  }
+
+  path_ = path;
+  size_ = st.st_size;
+
+  //nothing to map, but a valid (empty) file
+  if (!size_)
+  {
+    ::close(fd);
+    open_ = true;
+    return true;
+  }
+
+  void* mem = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);  //mapping keeps its own reference
+  if (mem == MAP_FAILED)
+  {
+    WARN << "<MappedFile> Could not map " << path << ": " << std::strerror(errno);
+    path_.clear();
+    size_ = 0;
+    return false;
+  }
+
+  ::madvise(mem, size_, MADV_SEQUENTIAL);
+  data_ = static_cast<const char*>(mem);
+  open_ = true;
+  return true;
+}
+
+void MappedFile::close()
+{
+  if (data_)
+    ::munmap(const_cast<char*>(data_), size_);
+  data_ = nullptr;
+  size_ = 0;
+  path_.clear();
+  open_ = false;
+}
+
+void MappedFile::will_need(size_t offset, size_t length) const
+{
+  if (!data_ || (offset >= size_))
+    return;
+  length = std::min(length, size_ - offset);
+
+  //madvise wants a page-aligned start
+  static const size_t page = ::sysconf(_SC_PAGESIZE);
+  size_t start = offset / page * page;
+  ::madvise(const_cast<char*>(data_) + start, length + (offset - start), MADV_WILLNEED);
+}
+
+}
@@ -0,0 +1,56 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::MappedFile  read-only memory map of a whole file, advised for
+ *                       sequential access. Share it through a TraceArena
+ *                       (TraceArena::hold) to let hits point into it.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+namespace Qpx {
+
+class MappedFile
+{
+public:
+  MappedFile() {}
+  ~MappedFile() { close(); }
+
+  bool open(const std::string& path);
+  void close();
+
+  bool is_open() const { return open_; }
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+  //hint that [offset, offset+length) is needed soon
+  void will_need(size_t offset, size_t length) const;
+
+private:
+  bool open_ {false};
+  std::string path_;
+  const char* data_ {nullptr};
+  size_t size_ {0};
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+};
+
+typedef std::shared_ptr<MappedFile> MappedFilePtr;
+
+}
@@ -23,11 +23,27 @@
 
 namespace Qpx {
 
+void Pattern::compile()
+{
+  mask_.clear();
+  overflow_.clear();
+  for (size_t i=0; i < gates_.size(); ++i)
+  {
+    if (!gates_[i])
+      continue;
+    if (ChannelMask::in_range(i))
+      mask_.set(i);
+    else
+      overflow_.push_back(i);
+  }
+}
+
 void Pattern::resize(size_t sz)
 {
   gates_.resize(sz);
   if (threshold_ > sz)
     threshold_ = sz;
+  compile();
 }
 
 void Pattern::set_gates(std::vector<bool> gts)
@@ -35,6 +51,7 @@ void Pattern::set_gates(std::vector<bool> gts)
   gates_ = gts;
   if (threshold_ > gates_.size())
     threshold_ = gates_.size();
+  compile();
 }
 
 void Pattern::set_theshold(size_t sz)
@@ -80,6 +97,7 @@ void Pattern::gates_from_string(std::string s)
     }
   }
   gates_ = gts;
+  compile();
 }
 
 std::string Pattern::to_string() const
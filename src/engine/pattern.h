@@ -33,6 +33,10 @@ class Pattern
 private:
   std::vector<bool> gates_;
   size_t threshold_ {0};
+  ChannelMask mask_;  //gates_ compiled
+  std::vector<int16_t> overflow_;  //gated channels past mask range
+
+  void compile();
 
 public:
   inline Pattern() {}
@@ -47,46 +51,44 @@ public:
   size_t threshold() const { return threshold_; }
   void set_gates(std::vector<bool>);
   void set_theshold(size_t);
+  const ChannelMask& mask() const { return mask_; }
 
   inline bool relevant(size_t chan) const
   {
+    if (chan < static_cast<size_t>(ChannelMask::kChannels))
+      return mask_.test(chan);
     if (chan >= gates_.size())
       return false;
     return gates_[chan];
   }
 
+  //gated channels past mask range, in order
+  const std::vector<int16_t>& overflow() const { return overflow_; }
+
+  //at least threshold of the gated channels present
   inline bool validate(const Event &e) const
   {
     if (threshold_ == 0)
       return true;
-    size_t matches = 0;
-    for (auto &h : e.hits)
-    {
-      if ((h.first < 0) || (h.first >= static_cast<int16_t>(gates_.size())))
-        continue;
-      else if (gates_[h.first])
-        matches++;
-      if (matches == threshold_)
-        break;
-    }
-    return (matches == threshold_);
+    size_t present = (e.hits.mask() & mask_).count();
+    if (e.hits.has_overflow())
+      for (auto c : overflow_)
+        present += e.hits.count(c);
+    return (present >= threshold_);
   }
 
+  //none of the gated channels present
   inline bool antivalidate(const Event &e) const
   {
     if (threshold_ == 0)
       return true;
-    size_t matches = threshold_;
-    for (auto &h : e.hits)
-    {
-      if ((h.first < 0) || (h.first >= static_cast<int16_t>(gates_.size())))
-        continue;
-      else if (gates_[h.first])
-        matches--;
-      if (matches < threshold_)
-        break;
-    }
-    return (matches == threshold_);
+    if (!(e.hits.mask() & mask_).none())
+      return false;
+    if (e.hits.has_overflow())
+      for (auto c : overflow_)
+        if (e.hits.count(c))
+          return false;
+    return true;
   }
 
   std::string to_string() const;
@@ -0,0 +1,202 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::PipelineMetrics  per-stage counters and latency histograms
+ *
+ ******************************************************************************/
+
+#include "pipeline_metrics.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace Qpx {
+
+size_t LatencyHistogram::bucket(uint64_t ns)
+{
+  const uint64_t sub = (1 << kSubBits);
+  if (ns < sub)
+    return ns;
+
+  size_t msb = 63 - __builtin_clzll(ns);
+  if (msb > kMaxMagnitude)
+    return kBuckets - 1;
+
+  size_t shift = msb - kSubBits;
+  return sub + shift * sub + ((ns >> shift) & (sub - 1));
+}
+
+uint64_t LatencyHistogram::bucket_low(size_t idx)
+{
+  const uint64_t sub = (1 << kSubBits);
+  if (idx < sub)
+    return idx;
+  size_t shift = (idx - sub) / sub;
+  return (sub + (idx - sub) % sub) << shift;
+}
+
+void LatencyHistogram::reset()
+{
+  for (size_t i=0; i < kBuckets; ++i)
+    buckets_[i].store(0, std::memory_order_relaxed);
+  count_.store(0, std::memory_order_relaxed);
+  sum_.store(0, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const
+{
+  uint64_t c = count();
+  if (!c)
+    return 0;
+  return double(sum_.load(std::memory_order_relaxed)) / double(c);
+}
+
+double LatencyHistogram::percentile(double q) const
+{
+  uint64_t c = count();
+  if (!c)
+    return 0;
+
+  uint64_t rank = static_cast<uint64_t>(q * (c - 1)) + 1;
+  uint64_t seen = 0;
+  for (size_t i=0; i < kBuckets; ++i)
+  {
+    seen += buckets_[i].load(std::memory_order_relaxed);
+    if (seen >= rank)
+    {
+      double low = bucket_low(i);
+      double high = (i + 1 < kBuckets) ? bucket_low(i + 1) : low;
+      return std::min((low + high) * 0.5, double(max()));
+    }
+  }
+  return max();
+}
+
+void StageMetrics::reset()
+{
+  calls_.store(0);
+  items_.store(0);
+  busy_ns_.store(0);
+  depth_.store(0);
+  max_depth_.store(0);
+  latency_.reset();
+}
+
+StageSnapshot StageMetrics::snapshot(double elapsed_s) const
+{
+  StageSnapshot ret;
+  ret.name      = name_;
+  ret.calls     = calls_.load(std::memory_order_relaxed);
+  ret.items     = items_.load(std::memory_order_relaxed);
+  ret.busy_s    = busy_ns_.load(std::memory_order_relaxed) * 1.0e-9;
+  if (elapsed_s > 0)
+    ret.items_per_s = ret.items / elapsed_s;
+  ret.mean_us   = latency_.mean() * 0.001;
+  ret.p50_us    = latency_.percentile(0.50) * 0.001;
+  ret.p90_us    = latency_.percentile(0.90) * 0.001;
+  ret.p99_us    = latency_.percentile(0.99) * 0.001;
+  ret.max_us    = latency_.max() * 0.001;
+  ret.depth     = depth_.load(std::memory_order_relaxed);
+  ret.max_depth = max_depth_.load(std::memory_order_relaxed);
+  return ret;
+}
+
+StageMetrics* PipelineMetrics::stage(const std::string& name)
+{
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  auto it = by_name_.find(name);
+  if (it != by_name_.end())
+    return it->second;
+  stages_.push_back(std::unique_ptr<StageMetrics>(new StageMetrics(name)));
+  by_name_[name] = stages_.back().get();
+  return stages_.back().get();
+}
+
+void PipelineMetrics::reset()
+{
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  for (auto &s : stages_)
+    s->reset();
+  start_ = std::chrono::steady_clock::now();
+}
+
+MetricsSnapshot PipelineMetrics::snapshot() const
+{
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  MetricsSnapshot ret;
+  ret.elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+  for (auto &s : stages_)
+    ret.stages.push_back(s->snapshot(ret.elapsed_s));
+  return ret;
+}
+
+std::string MetricsSnapshot::to_string() const
+{
+  std::stringstream ss;
+  ss << "Pipeline metrics over " << std::fixed << std::setprecision(3) << elapsed_s << " s\n";
+  ss << std::left << std::setw(24) << "stage"
+     << std::right
+     << std::setw(10) << "calls"
+     << std::setw(14) << "items"
+     << std::setw(14) << "items/s"
+     << std::setw(10) << "busy s"
+     << std::setw(12) << "p50 us"
+     << std::setw(12) << "p99 us"
+     << std::setw(12) << "max us"
+     << std::setw(8)  << "depth"
+     << std::setw(8)  << "max"
+     << "\n";
+  for (auto &s : stages)
+    ss << std::left << std::setw(24) << s.name
+       << std::right << std::setprecision(1)
+       << std::setw(10) << s.calls
+       << std::setw(14) << s.items
+       << std::setw(14) << s.items_per_s
+       << std::setprecision(3)
+       << std::setw(10) << s.busy_s
+       << std::setprecision(1)
+       << std::setw(12) << s.p50_us
+       << std::setw(12) << s.p99_us
+       << std::setw(12) << s.max_us
+       << std::setw(8)  << s.depth
+       << std::setw(8)  << s.max_depth
+       << "\n";
+  return ss.str();
+}
+
+void to_json(json& j, const StageSnapshot &s)
+{
+  j["name"]        = s.name;
+  j["calls"]       = s.calls;
+  j["items"]       = s.items;
+  j["busy_s"]      = s.busy_s;
+  j["items_per_s"] = s.items_per_s;
+  j["mean_us"]     = s.mean_us;
+  j["p50_us"]      = s.p50_us;
+  j["p90_us"]      = s.p90_us;
+  j["p99_us"]      = s.p99_us;
+  j["max_us"]      = s.max_us;
+  j["depth"]       = s.depth;
+  j["max_depth"]   = s.max_depth;
+}
+
+void to_json(json& j, const MetricsSnapshot &s)
+{
+  j["elapsed_s"] = s.elapsed_s;
+  for (auto &q : s.stages)
+    j["stages"].push_back(q);
+}
+
+}
@@ -0,0 +1,216 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::LatencyHistogram  log-linear buckets (8 per power of two,
+ *                             i.e. within 12.5%), lock-free recording
+ *
+ *      Qpx::StageMetrics      calls, items, busy time, latency and queue
+ *                             depth for one pipeline stage
+ *
+ *      Qpx::StageTimer        times one pass through a stage
+ *
+ *      Qpx::PipelineMetrics   process-wide registry of stages, with
+ *                             snapshots for Engine, gui and cpx
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/thread/mutex.hpp>
+
+#include "json.hpp"
+using namespace nlohmann;
+
+namespace Qpx {
+
+//stage names used by the engine itself
+namespace Stage {
+const std::string read    = "read";     //producer pulls raw data
+const std::string parse   = "parse";    //raw data to hits
+const std::string queue   = "queue";    //waiting on the spill queue
+const std::string presort = "presort";  //time-ordering across devices
+const std::string build   = "build";    //shared event builders
+const std::string fill    = "fill ";    //prefix, followed by sink name
+const std::string write   = "write ";   //prefix, followed by file name; items are bytes
+}
+
+class LatencyHistogram
+{
+public:
+  static const size_t kSubBits = 3;
+  static const size_t kMaxMagnitude = 40;  //~18 min in ns; above is clamped
+  static const size_t kBuckets = (1 << kSubBits) * (kMaxMagnitude - kSubBits + 2);
+
+  LatencyHistogram() { reset(); }
+
+  inline void record(uint64_t ns)
+  {
+    buckets_[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t prev = max_.load(std::memory_order_relaxed);
+    while ((ns > prev) && !max_.compare_exchange_weak(prev, ns, std::memory_order_relaxed));
+  }
+
+  void reset();
+
+  uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+  uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+  double mean() const;
+
+  //q in [0,1]; midpoint of the bucket holding that rank
+  double percentile(double q) const;
+
+  static size_t bucket(uint64_t ns);
+  static uint64_t bucket_low(size_t idx);
+
+private:
+  std::atomic<uint64_t> buckets_[kBuckets];
+  std::atomic<uint64_t> count_;
+  std::atomic<uint64_t> sum_;
+  std::atomic<uint64_t> max_;
+};
+
+struct StageSnapshot
+{
+  std::string name;
+  uint64_t calls {0};
+  uint64_t items {0};
+  double   busy_s {0};
+  double   items_per_s {0};   //over wall time since reset
+  double   mean_us {0};
+  double   p50_us {0};
+  double   p90_us {0};
+  double   p99_us {0};
+  double   max_us {0};
+  int64_t  depth {0};
+  int64_t  max_depth {0};
+};
+
+void to_json(json& j, const StageSnapshot &s);
+
+struct MetricsSnapshot
+{
+  double elapsed_s {0};
+  std::vector<StageSnapshot> stages;
+
+  std::string to_string() const;
+};
+
+void to_json(json& j, const MetricsSnapshot &s);
+
+class StageMetrics
+{
+public:
+  explicit StageMetrics(const std::string& name) : name_(name) { reset(); }
+
+  const std::string& name() const { return name_; }
+
+  inline void record(uint64_t ns, uint64_t items)
+  {
+    calls_.fetch_add(1, std::memory_order_relaxed);
+    items_.fetch_add(items, std::memory_order_relaxed);
+    busy_ns_.fetch_add(ns, std::memory_order_relaxed);
+    latency_.record(ns);
+  }
+
+  inline void count(uint64_t items)
+  {
+    items_.fetch_add(items, std::memory_order_relaxed);
+  }
+
+  inline void depth(int64_t d)
+  {
+    depth_.store(d, std::memory_order_relaxed);
+    int64_t prev = max_depth_.load(std::memory_order_relaxed);
+    while ((d > prev) && !max_depth_.compare_exchange_weak(prev, d, std::memory_order_relaxed));
+  }
+
+  void reset();
+  StageSnapshot snapshot(double elapsed_s) const;
+
+private:
+  std::string name_;
+  std::atomic<uint64_t> calls_;
+  std::atomic<uint64_t> items_;
+  std::atomic<uint64_t> busy_ns_;
+  std::atomic<int64_t>  depth_;
+  std::atomic<int64_t>  max_depth_;
+  LatencyHistogram latency_;
+};
+
+class StageTimer
+{
+public:
+  explicit StageTimer(StageMetrics* stage)
+    : stage_(stage)
+    , start_(std::chrono::steady_clock::now())
+  {}
+
+  ~StageTimer() { stop(); }
+
+  void items(uint64_t n) { items_ = n; }
+
+  //records once; later calls and the destructor do nothing
+  void stop()
+  {
+    if (!stage_)
+      return;
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start_).count();
+    stage_->record(static_cast<uint64_t>(ns), items_);
+    stage_ = nullptr;
+  }
+
+private:
+  StageMetrics* stage_;
+  std::chrono::steady_clock::time_point start_;
+  uint64_t items_ {1};
+};
+
+class PipelineMetrics
+{
+public:
+  static PipelineMetrics& get()
+  {
+    static PipelineMetrics singleton_instance;
+    return singleton_instance;
+  }
+
+  //created on first use; pointer stays valid for the process lifetime
+  StageMetrics* stage(const std::string& name);
+
+  //zero all stages and restart the rate clock, e.g. at run start
+  void reset();
+
+  MetricsSnapshot snapshot() const;
+
+private:
+  mutable boost::mutex mutex_;
+  std::vector<std::unique_ptr<StageMetrics>> stages_;  //in order of first use
+  std::map<std::string, StageMetrics*> by_name_;
+  std::chrono::steady_clock::time_point start_ {std::chrono::steady_clock::now()};
+
+  PipelineMetrics() {}
+  PipelineMetrics(PipelineMetrics const&);
+  void operator=(PipelineMetrics const&);
+};
+
+}
@@ -23,7 +23,8 @@
 #pragma once
 
 #include "setting.h"
-#include "synchronized_queue.h"
+#include "setting_index.h"
+#include "spill_queue.h"
 #include "spill.h"
 #include "custom_logger.h"
 
@@ -50,7 +51,7 @@ inline ProducerStatus operator^(ProducerStatus a, ProducerStatus b)
   {return static_cast<ProducerStatus>(static_cast<int>(a) ^ static_cast<int>(b));}
 
 
-using SpillQueue = SynchronizedQueue<Spill*>*;
+using SpillQueue = BoundedSpillQueue*;
 
 class Producer
 {
@@ -73,6 +74,12 @@ public:
 
   virtual void write_settings_bulk(Qpx::Setting &/*set*/) {}
   virtual void read_settings_bulk(Qpx::Setting &/*set*/) const {}
+
+  //values along each path (set first, changed node last) are already
+  //updated; apply them and refresh whatever they affect, without changing
+  //structure. false = not handled, do a bulk round trip instead
+  virtual bool write_settings(Qpx::Setting &/*set*/,
+                              const std::list<Qpx::SettingPath> &/*changed*/) {return false;}
   virtual void get_all_settings() {}
 
   virtual std::list<Hit> oscilloscope() {return std::list<Hit>();}
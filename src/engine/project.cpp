@@ -48,6 +48,7 @@ Project::Project(const Project& other)
   sinks_ = other.sinks_;
   fitters_1d_ = other.fitters_1d_;
   spills_ = other.spills_;
+  parallel_dispatch_ = other.parallel_dispatch_;
   for (auto sink : other.sinks_)
     sinks_[sink.first] = ConsumerFactory::getInstance().create_copy(sink.second);
   DBG << "<Project> deep copy performed";
@@ -80,12 +81,22 @@ void Project::clear_helper()
   sinks_.clear();
   spills_.clear();
   fitters_1d_.clear();
+  stop_workers();
+  builders_.clear();
+  fill_stages_.clear();
   current_index_ = 0;
 }
 
 void Project::flush()
 {
   boost::unique_lock<boost::mutex> lock(mutex_);
+
+  //barrier: all dispatched spills ingested before end of run
+  for (auto &w : group_workers_)
+    w.second->wait_idle();
+  for (auto &w : sink_workers_)
+    w.second->wait_idle();
+
   if (!sinks_.empty())
     for (auto &q: sinks_) {
       //DBG << "closing " << q->name();
@@ -93,6 +104,40 @@ void Project::flush()
     }
 }
 
+void Project::set_parallel_dispatch(bool parallel)
+{
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  parallel_dispatch_ = parallel;
+  if (!parallel_dispatch_)
+    stop_workers();
+}
+
+bool Project::parallel_dispatch() const
+{
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  return parallel_dispatch_;
+}
+
+StageMetrics* Project::fill_stage(int64_t idx)
+{
+  //private, no lock needed
+  auto it = fill_stages_.find(idx);
+  if (it != fill_stages_.end())
+    return it->second;
+  std::string name = sinks_.at(idx)->metadata().get_attribute("name").value_text;
+  StageMetrics* stage = PipelineMetrics::get().stage(Stage::fill + std::to_string(idx) + " " + name);
+  fill_stages_[idx] = stage;
+  return stage;
+}
+
+void Project::stop_workers()
+{
+  //private, no lock needed
+  //workers finish what is queued before joining
+  group_workers_.clear();
+  sink_workers_.clear();
+}
+
 void Project::activate()
 {
   boost::unique_lock<boost::mutex> lock(mutex_);
@@ -253,6 +298,7 @@ void Project::delete_sink(int64_t idx)
     return;
 
   sinks_.erase(idx);
+  fill_stages_.erase(idx);
   changed_ = true;
   ready_ = true;
   newdata_ = false;
@@ -284,12 +330,93 @@ void Project::set_prototypes(const XMLableDB<ConsumerMetadata>& prototypes)
   cond_.notify_all();
 }
 
-void Project::add_spill(Spill* one_spill)
+void Project::add_spill(SpillPtr one_spill)
 {
   boost::unique_lock<boost::mutex> lock(mutex_);
 
-  for (auto &q: sinks_)
-    q.second->push_spill(*one_spill);
+  if (!one_spill)
+    return;
+
+  //shared read-only by all sinks, possibly on several threads
+  std::shared_ptr<const Spill> spill = one_spill;
+
+  //sinks with identical coincidence requirements share one event builder
+  typedef std::pair<SinkPtr, StageMetrics*> TimedSink;
+  std::map<CoincidenceSetup, std::list<TimedSink>> groups;
+  std::set<int64_t> standalone;
+  for (auto &q: sinks_) {
+    CoincidenceSetup setup;
+    if (q.second->coincidence_setup(setup))
+      groups[setup].push_back(TimedSink(q.second, fill_stage(q.first)));
+    else
+      standalone.insert(q.first);
+  }
+
+  StageMetrics* build_stage = PipelineMetrics::get().stage(Stage::build);
+
+  for (auto it = builders_.begin(); it != builders_.end(); )
+    if (!groups.count(it->first))
+      it = builders_.erase(it);
+    else
+      ++it;
+
+  for (auto it = group_workers_.begin(); it != group_workers_.end(); )
+    if (!parallel_dispatch_ || !groups.count(it->first))
+      it = group_workers_.erase(it);
+    else
+      ++it;
+
+  for (auto it = sink_workers_.begin(); it != sink_workers_.end(); )
+    if (!parallel_dispatch_ || !standalone.count(it->first))
+      it = sink_workers_.erase(it);
+    else
+      ++it;
+
+  for (auto &i : standalone) {
+    SinkPtr sink = sinks_.at(i);
+    StageMetrics* stage = fill_stage(i);
+    DispatchWorker::Job job = [sink, stage, spill]() {
+      StageTimer timer(stage);
+      timer.items(spill->hits.size());
+      sink->push_spill(*spill);
+    };
+    if (!parallel_dispatch_)
+      job();
+    else {
+      if (!sink_workers_.count(i))
+        sink_workers_[i] = std::make_shared<DispatchWorker>();
+      stage->depth(sink_workers_[i]->enqueue(job));
+    }
+  }
+
+  for (auto &g : groups) {
+    if (!builders_.count(g.first))
+      builders_[g.first] = std::make_shared<EventBuilder>(g.first);
+    std::shared_ptr<EventBuilder> builder = builders_[g.first];
+    std::list<TimedSink> group_sinks = g.second;
+    DispatchWorker::Job job = [builder, build_stage, group_sinks, spill]() {
+      EventBatch events;
+      StageTimer build_timer(build_stage);
+      builder->push_spill(*spill, events);
+      build_timer.items(spill->hits.size());
+      build_timer.stop();
+      BuildCounts counts = builder->diagnostics().counts();
+      for (auto &q : group_sinks) {
+        StageTimer timer(q.second);
+        timer.items(events.size());
+        q.first->push_events(*spill, events, counts);
+      }
+      if (builder->diagnostics().due())
+        builder->diagnostics().report("shared by " + std::to_string(group_sinks.size()) + " sinks");
+    };
+    if (!parallel_dispatch_)
+      job();
+    else {
+      if (!group_workers_.count(g.first))
+        group_workers_[g.first] = std::make_shared<DispatchWorker>();
+      build_stage->depth(group_workers_[g.first]->enqueue(job));
+    }
+  }
 
   if (!one_spill->detectors.empty()
       || !one_spill->state.branches.empty())
@@ -26,6 +26,8 @@
 
 #include "consumer.h"
 #include "fitter.h"
+#include "dispatch_worker.h"
+#include "pipeline_metrics.h"
 
 #ifdef H5_ENABLED
 #include "H5CC_Group.h"
@@ -47,6 +49,17 @@ private:
   std::map<int64_t, Fitter> fitters_1d_;
   std::set<Spill> spills_;
 
+  //one per distinct coincidence setup, shared by sinks
+  std::map<CoincidenceSetup, std::shared_ptr<EventBuilder>> builders_;
+
+  //parallel dispatch: a thread per coincidence group or standalone sink
+  bool parallel_dispatch_ {false};
+  std::map<CoincidenceSetup, DispatchWorkerPtr> group_workers_;
+  std::map<int64_t, DispatchWorkerPtr> sink_workers_;
+
+  //per-sink fill timing, named on first use
+  std::map<int64_t, StageMetrics*> fill_stages_;
+
   //saveability
   std::string   identity_ {"New project"};
   mutable bool  changed_  {false};
@@ -74,9 +87,13 @@ public:
   void delete_sink(int64_t idx);
 
   //acquisition feeds events to all sinks
-  void add_spill(Spill* one_spill);
+  void add_spill(SpillPtr one_spill);
   void flush();
 
+  //sinks ingest spills on their own threads, synchronized at flush
+  void set_parallel_dispatch(bool);
+  bool parallel_dispatch() const;
+
   //status inquiry
   bool wait_ready();  //wait for cond variable
   bool new_data();    //any new since last readout?
@@ -113,6 +130,8 @@ public:
 private:
   //helpers
   void clear_helper();
+  void stop_workers();
+  StageMetrics* fill_stage(int64_t idx);
   void write_xml(std::string file_name);
   void read_xml(std::string file_name, bool with_sinks = true, bool with_full_sinks = true);
 
@@ -0,0 +1,279 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::SettingIndex   hash index over a settings tree
+ *
+ ******************************************************************************/
+
+#include "setting_index.h"
+#include <algorithm>
+#include <atomic>
+
+namespace Qpx {
+
+namespace {
+//unique across all indices, so a handle can never match a different tree
+std::atomic<uint64_t> next_generation {1};
+}
+
+void SettingIndex::invalidate()
+{
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  generation_ = 0;
+  root_ = nullptr;
+  by_id_.clear();
+  parent_.clear();
+  leaves_by_index_.clear();
+  unindexed_leaves_.clear();
+}
+
+bool SettingIndex::indexable(Match flags)
+{
+  return ((flags == Match::id) || (flags == (Match::id | Match::indices)));
+}
+
+void SettingIndex::ensure(const Setting& root) const
+{
+  if (generation_ && (root_ == &root))
+    return;
+  build(root);
+}
+
+void SettingIndex::build(const Setting& root) const
+{
+  by_id_.clear();
+  parent_.clear();
+  leaves_by_index_.clear();
+  unindexed_leaves_.clear();
+
+  Setting& r = const_cast<Setting&>(root);
+  size_t order = 0;
+  add_node(r, nullptr, order);
+  order = 0;
+  if (r.metadata.setting_type == SettingType::stem)
+    for (auto &q : r.branches.my_data_)
+      add_leaves(q, order);
+
+  root_ = &root;
+  generation_ = next_generation.fetch_add(1);
+}
+
+void SettingIndex::add_node(Setting& node, Setting* parent, size_t& order) const
+{
+  Ref ref(order++, &node);
+  parent_[&node] = parent;
+  Entry& e = by_id_[node.id_];
+  if (!e.any.second)
+    e.any = ref;
+  if (node.indices.empty())
+  {
+    if (!e.unindexed.second)
+      e.unindexed = ref;
+  }
+  else
+    for (auto &i : node.indices)
+      if (!e.indexed.count(i))
+        e.indexed[i] = ref;
+
+  //a matching node shadows its own branches, so those are ranked after it
+  if ((node.metadata.setting_type == SettingType::stem)
+      || (node.metadata.setting_type == SettingType::indicator))
+    for (auto &q : node.branches.my_data_)
+      add_node(q, &node, order);
+}
+
+void SettingIndex::add_leaves(Setting& node, size_t& order) const
+{
+  if (node.metadata.setting_type == SettingType::stem)
+  {
+    for (auto &q : node.branches.my_data_)
+      add_leaves(q, order);
+    return;
+  }
+  if (node.metadata.setting_type == SettingType::detector)
+    return;
+
+  Ref ref(order++, &node);
+  if (node.indices.empty())
+    unindexed_leaves_.push_back(ref);
+  else
+    for (auto &i : node.indices)
+      leaves_by_index_[i].push_back(ref);
+}
+
+Setting* SettingIndex::lookup(const std::string& id,
+                              const std::set<int32_t>& indices,
+                              Match flags) const
+{
+  auto it = by_id_.find(id);
+  if (it == by_id_.end())
+    return nullptr;
+  const Entry& e = it->second;
+
+  if (!(flags & Match::indices))
+    return e.any.second;
+
+  if (indices.empty())
+    return e.unindexed.second;
+
+  Ref best(SIZE_MAX, nullptr);
+  for (auto &i : indices)
+  {
+    auto found = e.indexed.find(i);
+    if ((found != e.indexed.end()) && (found->second.first < best.first))
+      best = found->second;
+  }
+  return best.second;
+}
+
+Setting* SettingIndex::find(Setting& root, const Setting& address, Match flags)
+{
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  ensure(root);
+  return lookup(address.id_, address.indices, flags);
+}
+
+const Setting* SettingIndex::find(const Setting& root, const Setting& address, Match flags) const
+{
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  ensure(root);
+  return lookup(address.id_, address.indices, flags);
+}
+
+std::list<Setting> SettingIndex::find_all(const Setting& root, const Setting& address, Match flags) const
+{
+  if (((flags != Match::indices) && (flags != (Match::id | Match::indices)))
+      || (root.metadata.setting_type != SettingType::stem))
+    return root.find_all(address, flags);
+
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  ensure(root);
+
+  std::vector<Ref> found;
+  if (address.indices.empty())
+    found = unindexed_leaves_;
+  else
+    for (auto &i : address.indices)
+    {
+      auto it = leaves_by_index_.find(i);
+      if (it != leaves_by_index_.end())
+        found.insert(found.end(), it->second.begin(), it->second.end());
+    }
+
+  //tree order, each leaf once even if it carries several of the indices
+  std::sort(found.begin(), found.end());
+  found.erase(std::unique(found.begin(), found.end()), found.end());
+
+  std::list<Setting> result;
+  for (auto &f : found)
+    if (!(flags & Match::id) || (f.second->id_ == address.id_))
+      result.push_back(*f.second);
+  return result;
+}
+
+Setting* SettingIndex::resolve(Setting& root, SettingHandle& handle)
+{
+  return const_cast<Setting*>(static_cast<const SettingIndex*>(this)->resolve(root, handle));
+}
+
+const Setting* SettingIndex::resolve(const Setting& root, SettingHandle& handle) const
+{
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  ensure(root);
+  if (handle.generation_ != generation_)
+  {
+    handle.target_ = lookup(handle.id_, handle.indices_, handle.flags_);
+    handle.generation_ = generation_;
+  }
+  return handle.target_;
+}
+
+SettingPath SettingIndex::path(Setting& root, const Setting* node)
+{
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  ensure(root);
+
+  SettingPath ret;
+  auto it = parent_.find(node);
+  while ((it != parent_.end()) && it->second)
+  {
+    ret.push_back(const_cast<Setting*>(it->first));
+    it = parent_.find(it->second);
+  }
+  std::reverse(ret.begin(), ret.end());
+  return ret;
+}
+
+bool values_equal(const Setting& a, const Setting& b)
+{
+  return ((a.value_int      == b.value_int) &&
+          (a.value_dbl      == b.value_dbl) &&
+          (a.value_precise  == b.value_precise) &&
+          (a.value_text     == b.value_text) &&
+          (a.value_time     == b.value_time) &&
+          (a.value_duration == b.value_duration) &&
+          (a.value_pattern  == b.value_pattern));
+}
+
+namespace {
+
+typedef std::pair<SettingPath, const Setting*> PendingChange;
+
+bool collect_changes(Setting& current, const Setting& incoming,
+                     SettingPath& path, std::list<PendingChange>& pending)
+{
+  if ((current.id_ != incoming.id_) ||
+      (current.indices != incoming.indices) ||
+      (current.branches.size() != incoming.branches.size()))
+    return false;
+
+  if (!path.empty() && !values_equal(current, incoming))
+    pending.push_back(PendingChange(path, &incoming));
+
+  auto in = incoming.branches.my_data_.begin();
+  for (auto &q : current.branches.my_data_)
+  {
+    path.push_back(&q);
+    bool same_shape = collect_changes(q, *in, path, pending);
+    path.pop_back();
+    if (!same_shape)
+      return false;
+    ++in;
+  }
+  return true;
+}
+
+}
+
+bool apply_changes(Setting& current, const Setting& incoming,
+                   std::list<SettingPath>& changed)
+{
+  SettingPath path;
+  std::list<PendingChange> pending;
+  if (!collect_changes(current, incoming, path, pending))
+    return false;
+
+  //the root's own value is not a setting of any device
+  if (!values_equal(current, incoming))
+    current.set_value(incoming);
+
+  for (auto &p : pending)
+  {
+    p.first.back()->set_value(*p.second);
+    changed.push_back(p.first);
+  }
+  return true;
+}
+
+}
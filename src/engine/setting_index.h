@@ -0,0 +1,128 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::SettingIndex   lazily built hash index over a settings tree,
+ *                          keyed on (id, index). Lookups give the same
+ *                          result as the recursive Setting functions.
+ *                          The owner of the tree must invalidate() after
+ *                          any structural change (branches added, removed
+ *                          or replaced); value changes need nothing.
+ *
+ *      Qpx::SettingHandle  cached address of one setting, re-resolved
+ *                          only when the index has been rebuilt
+ *
+ *      Qpx::apply_changes  value-only diff of two trees of the same shape,
+ *                          for pushing just what changed
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "setting.h"
+#include <unordered_map>
+#include <boost/thread/mutex.hpp>
+
+namespace Qpx {
+
+//from a direct branch of the root down to one node
+typedef std::vector<Setting*> SettingPath;
+
+class SettingHandle
+{
+public:
+  SettingHandle() {}
+  SettingHandle(std::string id, Match flags = Match::id | Match::indices)
+    : id_(id), flags_(flags) {}
+  SettingHandle(std::string id, int32_t idx, Match flags = Match::id | Match::indices)
+    : id_(id), indices_({idx}), flags_(flags) {}
+
+  const std::string& id() const { return id_; }
+
+private:
+  friend class SettingIndex;
+
+  std::string       id_;
+  std::set<int32_t> indices_;
+  Match             flags_ {Match::id};
+
+  uint64_t generation_ {0};
+  Setting* target_ {nullptr};
+};
+
+class SettingIndex
+{
+public:
+  SettingIndex() {}
+
+  //never shares state; a copied tree gets its own index on first use
+  SettingIndex(const SettingIndex&) {}
+  SettingIndex& operator=(const SettingIndex&) { invalidate(); return *this; }
+
+  void invalidate();
+
+  //flags the index can answer; others fall back to tree walk
+  static bool indexable(Match flags);
+
+  //as Setting::get_setting / has / set_setting_r; nullptr if absent
+  Setting* find(Setting& root, const Setting& address, Match flags);
+  const Setting* find(const Setting& root, const Setting& address, Match flags) const;
+
+  //as Setting::find_all
+  std::list<Setting> find_all(const Setting& root, const Setting& address, Match flags) const;
+
+  //pointer stays valid until the next structural change
+  Setting* resolve(Setting& root, SettingHandle& handle);
+  const Setting* resolve(const Setting& root, SettingHandle& handle) const;
+
+  //empty if node is the root or not in the tree
+  SettingPath path(Setting& root, const Setting* node);
+
+private:
+  typedef std::pair<size_t, Setting*> Ref;   //preorder position, node
+
+  struct Entry
+  {
+    Ref any       {SIZE_MAX, nullptr};       //first with this id
+    Ref unindexed {SIZE_MAX, nullptr};       //first with this id and no indices
+    std::unordered_map<int32_t, Ref> indexed;  //first carrying each index
+  };
+
+  mutable boost::mutex mutex_;
+  mutable const Setting* root_ {nullptr};
+  mutable uint64_t generation_ {0};  //0 = not built
+
+  //nodes reachable as in get_setting: through stems and indicators
+  mutable std::unordered_map<std::string, Entry> by_id_;
+  mutable std::unordered_map<const Setting*, Setting*> parent_;
+
+  //leaves reachable as in find_all: through stems only
+  mutable std::unordered_map<int32_t, std::vector<Ref>> leaves_by_index_;
+  mutable std::vector<Ref> unindexed_leaves_;
+
+  void ensure(const Setting& root) const;
+  void build(const Setting& root) const;
+  void add_node(Setting& node, Setting* parent, size_t& order) const;
+  void add_leaves(Setting& node, size_t& order) const;
+  Setting* lookup(const std::string& id, const std::set<int32_t>& indices, Match flags) const;
+};
+
+bool values_equal(const Setting& a, const Setting& b);
+
+//copies values from incoming where they differ and lists the nodes touched,
+//as paths from current's branches. Nothing is applied, and false returned,
+//if the trees differ in ids, indices or number of branches.
+bool apply_changes(Setting& current, const Setting& incoming,
+                   std::list<SettingPath>& changed);
+
+}
@@ -0,0 +1,48 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::Span  read-only view of contiguous elements, for passing
+ *                 batches without copying or committing to a container
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+namespace Qpx {
+
+template <typename T>
+class Span
+{
+public:
+  Span() {}
+  Span(const T* data, size_t size) : data_(data), size_(size) {}
+  Span(const std::vector<T>& v) : data_(v.data()), size_(v.size()) {}
+
+  inline const T* data() const { return data_; }
+  inline size_t size() const { return size_; }
+  inline bool empty() const { return (size_ == 0); }
+
+  inline const T* begin() const { return data_; }
+  inline const T* end() const { return data_ + size_; }
+  inline const T& operator[](size_t i) const { return data_[i]; }
+
+private:
+  const T* data_ {nullptr};
+  size_t size_ {0};
+};
+
+}
@@ -20,6 +20,7 @@
 #pragma once
 
 #include "stats_update.h"
+#include "hit_batch.h"
 #include <boost/date_time.hpp>
 #include "setting.h"
 #include "detector.h"
@@ -36,7 +37,7 @@ public:
   boost::posix_time::ptime time
     {boost::posix_time::microsec_clock::universal_time()};
   std::vector<uint32_t>  data;  //as is from device, unparsed
-  std::list<Qpx::Hit>    hits;  //as parsed
+  Qpx::HitBatch          hits;  //as parsed
   std::map<int16_t, StatsUpdate> stats;
 
   Qpx::Setting state;
@@ -0,0 +1,379 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Bounded multi-producer single-consumer spill queue.
+ *
+ ******************************************************************************/
+
+#include "spill_queue.h"
+#include "custom_logger.h"
+#include "custom_timer.h"
+
+#include <sstream>
+#include <boost/filesystem.hpp>
+
+namespace Qpx {
+
+//timed waits bound any wakeup missed by the lock-free side
+static const boost::chrono::milliseconds kWaitSlice(10);
+
+std::string BoundedSpillQueue::Stats::to_string() const
+{
+  std::stringstream ss;
+  ss << "enqueued=" << enqueued
+     << " dequeued=" << dequeued
+     << " dropped=" << dropped
+     << " spilled_to_disk=" << spilled_to_disk
+     << " high_water_mark=" << high_water_mark
+     << " producer_wait=" << producer_wait_ms << "ms"
+     << " consumer_wait=" << consumer_wait_ms << "ms";
+  return ss.str();
+}
+
+BoundedSpillQueue::BoundedSpillQueue(size_t capacity, Policy policy,
+                                     std::string overflow_dir)
+  : policy_(policy)
+{
+  size_t cap = 2;
+  while (cap < capacity)
+    cap <<= 1;
+  mask_ = cap - 1;
+  cells_.reset(new Cell[cap]);
+  for (size_t i = 0; i < cap; ++i)
+    cells_[i].sequence.store(i, boost::memory_order_relaxed);
+
+  if (policy_ == Policy::spill_to_disk)
+  {
+    boost::filesystem::path dir(overflow_dir);
+    if (overflow_dir.empty())
+      dir = boost::filesystem::temp_directory_path();
+    overflow_path_ = (dir / boost::filesystem::unique_path("qpx_spills_%%%%-%%%%.bin")).string();
+  }
+}
+
+BoundedSpillQueue::~BoundedSpillQueue()
+{
+  stop();
+  Spill* spill;
+  while ((spill = try_pop()) != nullptr)
+    delete spill;
+  boost::unique_lock<boost::mutex> lock(overflow_mutex_);
+  close_overflow();
+}
+
+bool BoundedSpillQueue::try_push(Spill* spill)
+{
+  Cell* cell;
+  size_t pos = enqueue_pos_.load(boost::memory_order_relaxed);
+  while (true)
+  {
+    cell = &cells_[pos & mask_];
+    size_t seq = cell->sequence.load(boost::memory_order_acquire);
+    intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+    if (dif == 0)
+    {
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, boost::memory_order_relaxed))
+        break;
+    }
+    else if (dif < 0)
+      return false;
+    else
+      pos = enqueue_pos_.load(boost::memory_order_relaxed);
+  }
+  cell->data = spill;
+  cell->sequence.store(pos + 1, boost::memory_order_release);
+  return true;
+}
+
+Spill* BoundedSpillQueue::try_pop()
+{
+  Cell* cell;
+  size_t pos = dequeue_pos_.load(boost::memory_order_relaxed);
+  while (true)
+  {
+    cell = &cells_[pos & mask_];
+    size_t seq = cell->sequence.load(boost::memory_order_acquire);
+    intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+    if (dif == 0)
+    {
+      if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, boost::memory_order_relaxed))
+        break;
+    }
+    else if (dif < 0)
+      return nullptr;
+    else
+      pos = dequeue_pos_.load(boost::memory_order_relaxed);
+  }
+  Spill* spill = cell->data;
+  cell->data = nullptr;
+  cell->sequence.store(pos + mask_ + 1, boost::memory_order_release);
+  return spill;
+}
+
+void BoundedSpillQueue::note_depth()
+{
+  uint32_t depth = size();
+  uint32_t hwm = high_water_mark_.load(boost::memory_order_relaxed);
+  while ((depth > hwm) &&
+         !high_water_mark_.compare_exchange_weak(hwm, depth, boost::memory_order_relaxed));
+}
+
+bool BoundedSpillQueue::enqueue(std::unique_ptr<Spill> spill)
+{
+  if (!spill)
+    return false;
+
+  Spill* raw = spill.release();
+
+  //once anything is on disk, later spills follow it there to keep order
+  if ((policy_ == Policy::spill_to_disk) && overflow_pending_.load())
+  {
+    if (!write_overflow(raw))
+      return false;
+  }
+  else if (try_push(raw))
+    enqueued_++;
+  else if (policy_ == Policy::drop)
+  {
+    delete raw;
+    dropped_++;
+    return false;
+  }
+  else if (policy_ == Policy::spill_to_disk)
+  {
+    if (!write_overflow(raw))
+      return false;
+  }
+  else
+  {
+    CustomTimer wait_timer(true);
+    producers_waiting_++;
+    bool pushed = false;
+    {
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      while (!(pushed = try_push(raw)) && !end_queue_.load())
+        not_full_.wait_for(lock, kWaitSlice);
+    }
+    producers_waiting_--;
+    producer_wait_us_ += static_cast<uint64_t>(wait_timer.us());
+    if (!pushed)
+    {
+      delete raw;
+      dropped_++;
+      return false;
+    }
+    enqueued_++;
+  }
+
+  note_depth();
+  not_empty_.notify_one();
+  return true;
+}
+
+std::unique_ptr<Spill> BoundedSpillQueue::dequeue()
+{
+  CustomTimer wait_timer;
+  while (!end_queue_.load())
+  {
+    Spill* spill = try_pop();
+    if (!spill && overflow_pending_.load())
+      spill = read_overflow();
+
+    if (spill)
+    {
+      dequeued_++;
+      consumer_wait_us_ += static_cast<uint64_t>(wait_timer.us());
+      if (producers_waiting_.load())
+      {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        not_full_.notify_all();
+      }
+      return std::unique_ptr<Spill>(spill);
+    }
+
+    wait_timer.resume();
+    {
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      if (!end_queue_.load() && !size())
+        not_empty_.wait_for(lock, kWaitSlice);
+    }
+    wait_timer.stop();
+  }
+  return std::unique_ptr<Spill>();
+}
+
+void BoundedSpillQueue::stop()
+{
+  end_queue_.store(true);
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  not_empty_.notify_all();
+  not_full_.notify_all();
+}
+
+uint32_t BoundedSpillQueue::size() const
+{
+  size_t in  = enqueue_pos_.load(boost::memory_order_acquire);
+  size_t out = dequeue_pos_.load(boost::memory_order_acquire);
+  size_t ring = (in > out) ? (in - out) : 0;
+  return static_cast<uint32_t>(ring + overflow_pending_.load());
+}
+
+BoundedSpillQueue::Stats BoundedSpillQueue::stats() const
+{
+  Stats ret;
+  ret.enqueued         = enqueued_.load() + spilled_.load();
+  ret.dequeued         = dequeued_.load();
+  ret.dropped          = dropped_.load();
+  ret.spilled_to_disk  = spilled_.load();
+  ret.high_water_mark  = high_water_mark_.load();
+  ret.producer_wait_ms = producer_wait_us_.load() / 1000.0;
+  ret.consumer_wait_ms = consumer_wait_us_.load() / 1000.0;
+  return ret;
+}
+
+bool BoundedSpillQueue::write_overflow(Spill* spill)
+{
+  std::unique_ptr<Spill> owned(spill);
+  boost::unique_lock<boost::mutex> lock(overflow_mutex_);
+
+  if (!overflow_out_.is_open())
+  {
+    overflow_out_.open(overflow_path_, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+    if (!overflow_out_.is_open())
+    {
+      ERR << "<BoundedSpillQueue> Could not open overflow file " << overflow_path_
+          << ", dropping spill";
+      dropped_++;
+      return false;
+    }
+    LINFO << "<BoundedSpillQueue> Queue full, overflowing to " << overflow_path_;
+  }
+
+  //hits are written in native binary form, with models derived from the hits themselves
+  std::map<int16_t, HitModel> models;
+  for (const auto &h : owned->hits)
+  {
+    if (models.count(h.source_channel()))
+      continue;
+    HitModel model;
+    model.timebase = TimeStamp(h.timestamp().timebase_multiplier(),
+                               h.timestamp().timebase_divider());
+    for (size_t i = 0; i < h.value_count(); ++i)
+      model.add_value(std::to_string(i), h.value(i).bits());
+    model.tracelength = h.trace_length();
+    models[h.source_channel()] = model;
+  }
+
+  json j;
+  j["spill"] = *owned;
+  for (auto &m : models)
+  {
+    json jj;
+    jj["channel"] = m.first;
+    jj["model"] = m.second;
+    j["models"].push_back(jj);
+  }
+
+  std::string header = j.dump();
+  uint64_t header_size = header.size();
+  uint64_t data_size = owned->data.size();
+  uint64_t hit_count = owned->hits.size();
+
+  overflow_out_.write((char*)&header_size, sizeof(header_size));
+  overflow_out_.write(header.data(), header_size);
+  overflow_out_.write((char*)&data_size, sizeof(data_size));
+  if (data_size)
+    overflow_out_.write((char*)owned->data.data(), sizeof(uint32_t) * data_size);
+  overflow_out_.write((char*)&hit_count, sizeof(hit_count));
+  for (const auto &h : owned->hits)
+    h.write_bin(overflow_out_);
+  overflow_out_.flush();
+
+  overflow_pending_++;
+  spilled_++;
+  return true;
+}
+
+Spill* BoundedSpillQueue::read_overflow()
+{
+  boost::unique_lock<boost::mutex> lock(overflow_mutex_);
+  if (!overflow_pending_.load())
+    return nullptr;
+
+  if (!overflow_in_.is_open())
+    overflow_in_.open(overflow_path_, std::ifstream::in | std::ifstream::binary);
+
+  std::unique_ptr<Spill> spill(new Spill);
+
+  uint64_t header_size = 0;
+  overflow_in_.read(reinterpret_cast<char*>(&header_size), sizeof(header_size));
+  std::string header(header_size, '\0');
+  overflow_in_.read(&header[0], header_size);
+
+  std::map<int16_t, HitModel> models;
+  try
+  {
+    json j = json::parse(header);
+    from_json(j["spill"], *spill);
+    if (j.count("models"))
+      for (auto it : j["models"])
+        models[it["channel"].get<int16_t>()] = it["model"];
+  }
+  catch (...)
+  {
+    ERR << "<BoundedSpillQueue> Corrupt spill header in overflow file " << overflow_path_;
+  }
+
+  uint64_t data_size = 0;
+  overflow_in_.read(reinterpret_cast<char*>(&data_size), sizeof(data_size));
+  spill->data.resize(data_size);
+  if (data_size)
+    overflow_in_.read(reinterpret_cast<char*>(spill->data.data()), sizeof(uint32_t) * data_size);
+
+  uint64_t hit_count = 0;
+  overflow_in_.read(reinterpret_cast<char*>(&hit_count), sizeof(hit_count));
+  TraceArenaPtr traces = std::make_shared<TraceArena>();
+  for (uint64_t i = 0; (i < hit_count) && overflow_in_.good(); ++i)
+  {
+    Hit hit;
+    hit.read_bin(overflow_in_, models, traces);
+    spill->hits.push_back(hit);
+  }
+
+  if (!overflow_in_.good())
+    ERR << "<BoundedSpillQueue> Failed reading back spill from " << overflow_path_;
+
+  overflow_pending_--;
+  if (!overflow_pending_.load())
+    close_overflow();
+
+  return spill.release();
+}
+
+void BoundedSpillQueue::close_overflow()
+{
+  if (overflow_out_.is_open())
+    overflow_out_.close();
+  if (overflow_in_.is_open())
+    overflow_in_.close();
+  overflow_in_.clear();
+  overflow_pending_.store(0);
+  if (!overflow_path_.empty())
+  {
+    boost::system::error_code ec;
+    boost::filesystem::remove(overflow_path_, ec);
+  }
+}
+
+}
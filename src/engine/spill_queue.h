@@ -0,0 +1,120 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Bounded multi-producer single-consumer spill queue. Lock-free ring
+ *      of owned spills; when full, the producer is blocked, the spill is
+ *      dropped (and counted) or written to an overflow file, depending on
+ *      the backpressure policy.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <fstream>
+#include <boost/thread.hpp>
+#include <boost/atomic.hpp>
+
+#include "spill.h"
+
+namespace Qpx {
+
+class BoundedSpillQueue
+{
+public:
+  enum class Policy { block, drop, spill_to_disk };
+
+  struct Stats
+  {
+    uint64_t enqueued        {0};
+    uint64_t dequeued        {0};
+    uint64_t dropped         {0};
+    uint64_t spilled_to_disk {0};
+    uint32_t high_water_mark {0};
+    double   producer_wait_ms{0};
+    double   consumer_wait_ms{0};
+
+    std::string to_string() const;
+  };
+
+  //capacity is rounded up to a power of 2
+  //overflow_dir defaults to system temp directory
+  BoundedSpillQueue(size_t capacity = 1024,
+                    Policy policy = Policy::block,
+                    std::string overflow_dir = "");
+  ~BoundedSpillQueue();
+
+  //false if spill was dropped
+  bool enqueue(std::unique_ptr<Spill> spill);
+
+  //blocks until data is available; nullptr once stopped
+  std::unique_ptr<Spill> dequeue();
+
+  void stop();
+
+  uint32_t size() const;
+  size_t capacity() const {return mask_ + 1;}
+  Policy policy() const {return policy_;}
+  Stats stats() const;
+
+private:
+  struct Cell
+  {
+    boost::atomic<size_t> sequence;
+    Spill* data {nullptr};
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t mask_;
+  Policy policy_;
+
+  boost::atomic<size_t> enqueue_pos_ {0};
+  boost::atomic<size_t> dequeue_pos_ {0};
+  boost::atomic<bool>   end_queue_ {false};
+
+  //sleeping only; the ring itself is never locked
+  boost::mutex mutex_;
+  boost::condition_variable not_empty_;
+  boost::condition_variable not_full_;
+  boost::atomic<uint32_t> producers_waiting_ {0};
+
+  //counters
+  boost::atomic<uint64_t> enqueued_ {0};
+  boost::atomic<uint64_t> dequeued_ {0};
+  boost::atomic<uint64_t> dropped_ {0};
+  boost::atomic<uint64_t> spilled_ {0};
+  boost::atomic<uint32_t> high_water_mark_ {0};
+  boost::atomic<uint64_t> producer_wait_us_ {0};
+  boost::atomic<uint64_t> consumer_wait_us_ {0};
+
+  //overflow to disk, strictly FIFO after the ring
+  boost::mutex overflow_mutex_;
+  std::string overflow_path_;
+  std::ofstream overflow_out_;
+  std::ifstream overflow_in_;
+  boost::atomic<uint64_t> overflow_pending_ {0};
+
+  bool try_push(Spill* spill);
+  Spill* try_pop();
+  void note_depth();
+
+  bool write_overflow(Spill* spill);
+  Spill* read_overflow();
+  void close_overflow();
+
+  BoundedSpillQueue(const BoundedSpillQueue&) = delete;
+  BoundedSpillQueue& operator=(const BoundedSpillQueue&) = delete;
+};
+
+}
@@ -0,0 +1,169 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::StatsItems  interned stats counters
+ *
+ ******************************************************************************/
+
+#include "stats_items.h"
+#include <unordered_map>
+#include <algorithm>
+#include <stdexcept>
+#include <boost/thread/mutex.hpp>
+
+namespace Qpx {
+
+namespace StatsKey {
+
+namespace {
+
+struct Registry
+{
+  boost::mutex mutex;
+  std::unordered_map<std::string, size_t> slots;
+  std::vector<std::string> names;
+
+  Registry()
+  {
+    for (auto &n : {"native_time", "live_time", "live_trigger", "trigger_count"})
+    {
+      slots[n] = names.size();
+      names.push_back(n);
+    }
+  }
+};
+
+Registry& registry()
+{
+  static Registry reg;
+  return reg;
+}
+
+}
+
+size_t slot(const std::string& name)
+{
+  Registry& reg = registry();
+  boost::unique_lock<boost::mutex> lock(reg.mutex);
+  auto it = reg.slots.find(name);
+  if (it != reg.slots.end())
+    return it->second;
+  size_t ret = reg.names.size();
+  reg.slots[name] = ret;
+  reg.names.push_back(name);
+  return ret;
+}
+
+size_t find(const std::string& name)
+{
+  Registry& reg = registry();
+  boost::unique_lock<boost::mutex> lock(reg.mutex);
+  auto it = reg.slots.find(name);
+  return (it != reg.slots.end()) ? it->second : none;
+}
+
+std::string name(size_t slot)
+{
+  Registry& reg = registry();
+  boost::unique_lock<boost::mutex> lock(reg.mutex);
+  if (slot < reg.names.size())
+    return reg.names[slot];
+  return std::string();
+}
+
+}
+
+PreciseFloat StatsItems::at(size_t slot) const
+{
+  if (!count(slot))
+    throw std::out_of_range("StatsItems: no counter " + StatsKey::name(slot));
+  return values_[slot];
+}
+
+size_t StatsItems::count(const std::string& name) const
+{
+  return count(StatsKey::find(name));
+}
+
+PreciseFloat StatsItems::at(const std::string& name) const
+{
+  size_t slot = StatsKey::find(name);
+  if (!count(slot))
+    throw std::out_of_range("StatsItems: no counter " + name);
+  return values_[slot];
+}
+
+PreciseFloat& StatsItems::operator[](const std::string& name)
+{
+  return operator[](StatsKey::slot(name));
+}
+
+void StatsItems::clear()
+{
+  values_.clear();
+  present_.clear();
+  size_ = 0;
+}
+
+StatsItems StatsItems::operator-(const StatsItems& other) const
+{
+  StatsItems answer;
+  size_t common = std::min(present_.size(), other.present_.size());
+  answer.values_.resize(common, 0);
+  answer.present_.resize(common, false);
+  for (size_t i = 0; i < common; ++i)
+  {
+    if (!present_[i] || !other.present_[i])
+      continue;
+    answer.values_[i] = values_[i] - other.values_[i];
+    answer.present_[i] = true;
+    answer.size_++;
+  }
+  return answer;
+}
+
+StatsItems StatsItems::operator+(const StatsItems& other) const
+{
+  StatsItems answer;
+  size_t common = std::min(present_.size(), other.present_.size());
+  answer.values_.resize(common, 0);
+  answer.present_.resize(common, false);
+  for (size_t i = 0; i < common; ++i)
+  {
+    if (!present_[i] || !other.present_[i])
+      continue;
+    answer.values_[i] = values_[i] + other.values_[i];
+    answer.present_[i] = true;
+    answer.size_++;
+  }
+  return answer;
+}
+
+bool StatsItems::operator==(const StatsItems& other) const
+{
+  if (size_ != other.size_)
+    return false;
+  size_t longest = std::max(present_.size(), other.present_.size());
+  for (size_t i = 0; i < longest; ++i)
+  {
+    bool mine = count(i), theirs = other.count(i);
+    if (mine != theirs)
+      return false;
+    if (mine && (values_[i] != other.values_[i]))
+      return false;
+  }
+  return true;
+}
+
+}
@@ -0,0 +1,138 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::StatsKey    process-wide registry of counter names. Each name
+ *                       gets a fixed integer slot on first use; the ones
+ *                       producers and consumers share are predefined.
+ *
+ *      Qpx::StatsItems  counters of one StatsUpdate as a dense array
+ *                       indexed by slot, with presence flags. Lookup by
+ *                       slot is O(1); by name goes through the registry.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+#include "precise_float.h"
+
+namespace Qpx {
+
+namespace StatsKey {
+
+enum : size_t
+{
+  native_time = 0,  //device clock over the spill
+  live_time,
+  live_trigger,
+  trigger_count,
+  predefined
+};
+
+//returned by find for names never registered
+const size_t none = static_cast<size_t>(-1);
+
+//registers if new; slots are never reused
+size_t slot(const std::string& name);
+
+//read-only lookup, for queries that should not grow the registry
+size_t find(const std::string& name);
+
+//empty if never registered
+std::string name(size_t slot);
+
+}
+
+class StatsItems
+{
+public:
+  class const_iterator
+  {
+  public:
+    const_iterator(const StatsItems* items, size_t slot)
+      : items_(items), slot_(slot) { skip(); }
+
+    //name and value; names are looked up, so keep this off hot paths
+    std::pair<std::string, PreciseFloat> operator*() const
+    {
+      return std::pair<std::string, PreciseFloat>(StatsKey::name(slot_),
+                                                  items_->values_[slot_]);
+    }
+
+    size_t slot() const { return slot_; }
+    const_iterator& operator++() { ++slot_; skip(); return *this; }
+    bool operator!=(const const_iterator& o) const { return slot_ != o.slot_; }
+    bool operator==(const const_iterator& o) const { return slot_ == o.slot_; }
+
+  private:
+    const StatsItems* items_;
+    size_t slot_;
+    void skip()
+    {
+      while ((slot_ < items_->present_.size()) && !items_->present_[slot_])
+        ++slot_;
+    }
+  };
+
+  inline size_t count(size_t slot) const
+  {
+    return ((slot < present_.size()) && present_[slot]) ? 1 : 0;
+  }
+
+  //throws std::out_of_range if absent, as std::map::at
+  PreciseFloat at(size_t slot) const;
+
+  inline PreciseFloat& operator[](size_t slot)
+  {
+    if (slot >= present_.size())
+    {
+      present_.resize(slot + 1, false);
+      values_.resize(slot + 1, 0);
+    }
+    if (!present_[slot])
+    {
+      present_[slot] = true;
+      values_[slot] = 0;
+      size_++;
+    }
+    return values_[slot];
+  }
+
+  size_t count(const std::string& name) const;
+  PreciseFloat at(const std::string& name) const;
+  PreciseFloat& operator[](const std::string& name);
+
+  size_t size() const { return size_; }
+  bool empty() const { return !size_; }
+  void clear();
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, present_.size()); }
+
+  //only counters present in both
+  StatsItems operator-(const StatsItems& other) const;
+  StatsItems operator+(const StatsItems& other) const;
+
+  bool operator==(const StatsItems& other) const;
+  bool operator!=(const StatsItems& other) const { return !operator==(other); }
+
+private:
+  std::vector<PreciseFloat> values_;
+  std::vector<bool>         present_;
+  size_t                    size_ {0};
+};
+
+}
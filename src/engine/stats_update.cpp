@@ -52,9 +52,7 @@ StatsUpdate StatsUpdate::operator-(const StatsUpdate other) const
     return answer;
 
   //labtime?
-  for (auto &i : items)
-    if (other.items.count(i.first))
-      answer.items[i.first] = i.second - other.items.at(i.first);
+  answer.items = items - other.items;
   return answer;
 }
 
@@ -78,9 +76,7 @@ StatsUpdate StatsUpdate::operator+(const StatsUpdate other) const
     return answer;
 
   //labtime?
-  for (auto &i : items)
-    if (other.items.count(i.first))
-      answer.items[i.first] = i.second + other.items.at(i.first);
+  answer.items = items + other.items;
   return answer;
 }
 
@@ -106,7 +102,11 @@ void StatsUpdate::to_xml(pugi::xml_node &root) const
 
   if (items.size()) {
      pugi::xml_node its = node.append_child("Items");
-     for (auto &i : items) {
+     //by name, as written before counters were interned
+     std::map<std::string, PreciseFloat> sorted;
+     for (auto i : items)
+       sorted.insert(i);
+     for (auto &i : sorted) {
        std::stringstream ss;
        ss << std::setprecision(std::numeric_limits<PreciseFloat>::max_digits10) << i.second;
        its.append_attribute(i.first.c_str()).set_value(ss.str().c_str());
@@ -152,7 +152,7 @@ void to_json(json& j, const StatsUpdate& s)
   j["channel"] = s.source_channel;
   j["lab_time"] = boost::posix_time::to_iso_extended_string(s.lab_time);
   j["hit_model"] = s.model_hit;
-  for (auto &i : s.items)
+  for (auto i : s.items)
     j["items"][i.first] = i.second;
 }
 
@@ -22,6 +22,7 @@
 #include <boost/date_time.hpp>
 #include "hit_model.h"
 #include "precise_float.h"
+#include "stats_items.h"
 
 #include "xmlable.h"
 
@@ -44,7 +45,7 @@ struct StatsUpdate : public XMLable
   int16_t   source_channel {-1};
   HitModel  model_hit;
   boost::posix_time::ptime lab_time;  //timestamp at end of spill
-  std::map<std::string, PreciseFloat> items;
+  StatsItems items;
   
   std::string to_string() const;
 
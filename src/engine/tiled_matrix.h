@@ -0,0 +1,210 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::TiledMatrix 2D histogram of integer counters in square tiles.
+ *                       Tiles are allocated on first touch, dense within
+ *                       and sparse across, so increments are O(1) and
+ *                       empty regions cost one null pointer per tile.
+ *                       Copies share tiles; a shared tile is copied
+ *                       only when one side writes to it.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+namespace Qpx {
+
+template <typename Count>
+class TiledMatrix
+{
+public:
+  static const uint16_t kTileBits  = 6;
+  static const uint32_t kTileSide  = 1 << kTileBits;
+  static const uint32_t kTileMask  = kTileSide - 1;
+  static const uint32_t kTileCells = kTileSide * kTileSide;
+
+  TiledMatrix() {}
+
+  //default copy shares tiles: one reference count per allocated tile
+
+  inline void clear()
+  {
+    tiles_.clear();
+    touched_.clear();
+    side_ = 0;
+    tile_count_ = 0;
+  }
+
+  inline bool empty() const { return (tile_count_ == 0); }
+  inline size_t tile_count() const { return tile_count_; }
+  inline size_t bytes() const { return tile_count_ * kTileCells * sizeof(Count); }
+
+  inline Count add(uint16_t x, uint16_t y, Count n = 1)
+  {
+    size_t t = touch(x, y);
+    Count& c = tiles_[t].get()[cell(x, y)];
+    c += n;
+    return c;
+  }
+
+  inline void set(uint16_t x, uint16_t y, Count n)
+  {
+    size_t t = touch(x, y);
+    tiles_[t].get()[cell(x, y)] = n;
+  }
+
+  inline Count get(uint16_t x, uint16_t y) const
+  {
+    uint32_t tx = x >> kTileBits, ty = y >> kTileBits;
+    if ((tx >= side_) || (ty >= side_))
+      return 0;
+    const Tile& tile = tiles_[tx * side_ + ty];
+    if (!tile)
+      return 0;
+    return tile.get()[cell(x, y)];
+  }
+
+  //tiles written from now on are stamped with this, for for_each(since)
+  inline uint32_t epoch() const { return epoch_; }
+  inline void set_epoch(uint32_t epoch) { epoch_ = epoch; }
+
+  //any tile written at or after epoch
+  inline bool touched_since(uint32_t epoch) const
+  {
+    return std::any_of(touched_.begin(), touched_.end(),
+                       [epoch](uint32_t t) { return t >= epoch; });
+  }
+
+  //visits non-zero cells in row-major order, within inclusive bounds,
+  //in tiles written at or after since
+  //visitor(uint16_t x, uint16_t y, Count c)
+  template <typename Visitor>
+  void for_each(Visitor visit,
+                uint32_t x0 = 0, uint32_t x1 = UINT16_MAX,
+                uint32_t y0 = 0, uint32_t y1 = UINT16_MAX,
+                uint32_t since = 0) const
+  {
+    if (!side_ || (x0 > x1) || (y0 > y1))
+      return;
+    uint32_t last = side_ * kTileSide - 1;
+    x1 = std::min(x1, last);
+    y1 = std::min(y1, last);
+    for (uint32_t tx = (x0 >> kTileBits); tx <= (x1 >> kTileBits); ++tx)
+    {
+      uint32_t xa = std::max(x0, tx << kTileBits);
+      uint32_t xb = std::min(x1, (tx << kTileBits) | kTileMask);
+      for (uint32_t x = xa; x <= xb; ++x)
+        for (uint32_t ty = (y0 >> kTileBits); ty <= (y1 >> kTileBits); ++ty)
+        {
+          size_t t = tx * side_ + ty;
+          if (!tiles_[t] || (touched_[t] < since))
+            continue;
+          const Count* row = tiles_[t].get() + ((x & kTileMask) << kTileBits);
+          uint32_t ya = std::max(y0, ty << kTileBits);
+          uint32_t yb = std::min(y1, (ty << kTileBits) | kTileMask);
+          for (uint32_t y = ya; y <= yb; ++y)
+            if (row[y & kTileMask])
+              visit(static_cast<uint16_t>(x), static_cast<uint16_t>(y), row[y & kTileMask]);
+        }
+    }
+  }
+
+  //visits allocated tiles, cells row-major within tile
+  //visitor(uint16_t x_origin, uint16_t y_origin, const Count* cells)
+  template <typename Visitor>
+  void for_each_tile(Visitor visit) const
+  {
+    for (uint32_t tx = 0; tx < side_; ++tx)
+      for (uint32_t ty = 0; ty < side_; ++ty)
+        if (tiles_[tx * side_ + ty])
+          visit(static_cast<uint16_t>(tx << kTileBits),
+                static_cast<uint16_t>(ty << kTileBits),
+                tiles_[tx * side_ + ty].get());
+  }
+
+  //tile containing (x,y), allocated if needed; for bulk loading
+  inline Count* tile(uint16_t x, uint16_t y)
+  {
+    return tiles_[touch(x, y)].get();
+  }
+
+private:
+  typedef std::shared_ptr<Count> Tile;  //kTileCells, may be shared with copies
+
+  std::vector<Tile> tiles_;  //side_ x side_, row-major
+  std::vector<uint32_t> touched_;  //epoch of last write, per tile
+  uint32_t side_ {0};
+  uint32_t epoch_ {1};
+  size_t tile_count_ {0};
+
+  static inline uint32_t cell(uint16_t x, uint16_t y)
+  {
+    return ((x & kTileMask) << kTileBits) | (y & kTileMask);
+  }
+
+  inline size_t touch(uint16_t x, uint16_t y)
+  {
+    uint32_t tx = x >> kTileBits, ty = y >> kTileBits;
+    if ((tx >= side_) || (ty >= side_))
+      grow(std::max(tx, ty) + 1);
+    size_t t = tx * side_ + ty;
+    Tile& tile = tiles_[t];
+    if (!tile)
+    {
+      tile.reset(new Count[kTileCells](), std::default_delete<Count[]>());
+      tile_count_++;
+    }
+    else if (tile.use_count() > 1)
+    {
+      Tile own(new Count[kTileCells], std::default_delete<Count[]>());
+      std::memcpy(own.get(), tile.get(), kTileCells * sizeof(Count));
+      tile = std::move(own);
+    }
+    else
+    {
+      //pairs with the release of the last other owner; its reads are done
+      std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    touched_[t] = epoch_;
+    return t;
+  }
+
+  //index grows in powers of 2, existing tiles are moved not copied
+  void grow(uint32_t min_side)
+  {
+    uint32_t side = std::max(side_, uint32_t(1));
+    while (side < min_side)
+      side <<= 1;
+    std::vector<Tile> tiles(side * side);
+    std::vector<uint32_t> touched(side * side, 0);
+    for (uint32_t tx = 0; tx < side_; ++tx)
+      for (uint32_t ty = 0; ty < side_; ++ty)
+      {
+        tiles[tx * side + ty] = std::move(tiles_[tx * side_ + ty]);
+        touched[tx * side + ty] = touched_[tx * side_ + ty];
+      }
+    tiles_ = std::move(tiles);
+    touched_ = std::move(touched);
+    side_ = side;
+  }
+};
+
+}
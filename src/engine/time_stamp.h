@@ -59,6 +59,11 @@ public:
     return ret;
   }
 
+  inline uint64_t native() const
+  {
+    return time_native_;
+  }
+
   inline double timebase_multiplier() const
   {
     return timebase_multiplier_;
@@ -113,6 +118,11 @@ public:
       time_native_ += std::ceil(ns * double(timebase_divider_) / double(timebase_multiplier_));
   }
 
+  inline void delay_native(uint64_t ticks)
+  {
+    time_native_ += ticks;
+  }
+
   inline bool operator<(const TimeStamp& other) const
   {
     if (same_base((other)))
@@ -0,0 +1,143 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      Qpx::TraceArena  chunked storage for the traces of one spill.
+ *                       Traces are carved out of large chunks that never
+ *                       move, so hits can point into them; hits share
+ *                       ownership of the arena, which lives as long as
+ *                       any hit referring to it.
+ *      Qpx::TraceView   read-only window onto one stored trace.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace Qpx {
+
+class TraceView
+{
+public:
+  TraceView() {}
+  TraceView(const uint16_t* data, size_t size)
+    : data_(data), size_(size)
+  {}
+
+  inline const uint16_t* data() const { return data_; }
+  inline size_t size() const { return size_; }
+  inline bool empty() const { return (size_ == 0); }
+
+  inline const uint16_t* begin() const { return data_; }
+  inline const uint16_t* end() const { return data_ + size_; }
+
+  inline uint16_t operator[](size_t i) const { return data_[i]; }
+
+  inline uint16_t at(size_t i) const
+  {
+    if (i >= size_)
+      throw std::out_of_range("TraceView::at");
+    return data_[i];
+  }
+
+  inline std::vector<uint16_t> to_vector() const
+  {
+    return std::vector<uint16_t>(begin(), end());
+  }
+
+  inline bool operator==(const TraceView& other) const
+  {
+    return (size_ == other.size_) &&
+        ((data_ == other.data_) || std::equal(begin(), end(), other.begin()));
+  }
+
+  inline bool operator!=(const TraceView& other) const
+  {
+    return !operator==(other);
+  }
+
+private:
+  const uint16_t* data_ {nullptr};
+  size_t size_ {0};
+};
+
+//filled by one thread (the parser of the spill), read-only thereafter
+class TraceArena
+{
+public:
+  static const size_t kChunkSamples = 1 << 16;
+
+  TraceArena() {}
+
+  //zero-filled block of len samples, valid for the life of the arena
+  inline uint16_t* allocate(size_t len)
+  {
+    if (!len)
+      return nullptr;
+    if (len > kChunkSamples)
+    {
+      //oversized traces get a chunk of their own, current chunk stays open
+      chunks_.emplace_back(new uint16_t[len]());
+      bytes_ += len * sizeof(uint16_t);
+      return chunks_.back().get();
+    }
+    if (!current_ || (used_ + len > kChunkSamples))
+    {
+      chunks_.emplace_back(new uint16_t[kChunkSamples]());
+      bytes_ += kChunkSamples * sizeof(uint16_t);
+      current_ = chunks_.back().get();
+      used_ = 0;
+    }
+    uint16_t* ret = current_ + used_;
+    used_ += len;
+    return ret;
+  }
+
+  //copies up to len samples, zero-padding to len
+  inline uint16_t* store(const uint16_t* data, size_t count, size_t len)
+  {
+    uint16_t* ret = allocate(len);
+    if (ret && data && count)
+      std::memcpy(ret, data, std::min(count, len) * sizeof(uint16_t));
+    return ret;
+  }
+
+  //keeps memory owned elsewhere (e.g. a mapped file) alive as long as
+  //the arena, so traces may point into it instead of being copied
+  inline void hold(const std::shared_ptr<const void>& owner)
+  {
+    held_.push_back(owner);
+  }
+
+  inline size_t bytes() const { return bytes_; }
+
+private:
+  std::vector<std::unique_ptr<uint16_t[]>> chunks_;
+  std::vector<std::shared_ptr<const void>> held_;
+  uint16_t* current_ {nullptr};
+  size_t used_ {0};
+  size_t bytes_ {0};
+
+  TraceArena(const TraceArena&) = delete;
+  TraceArena& operator=(const TraceArena&) = delete;
+};
+
+typedef std::shared_ptr<TraceArena> TraceArenaPtr;
+
+}
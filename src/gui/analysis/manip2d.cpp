@@ -83,19 +83,16 @@ SinkPtr slice_rectangular(SinkPtr source, std::initializer_list<Pair> bounds, bo
   if (!ret)
     return nullptr;
 
-  std::shared_ptr<EntryList> spectrum_data = std::move(source->data_range(bounds));
-  if (det1)
-    for (auto it : *spectrum_data)
-    {
-      Entry entry({it.first[0]}, it.second);
-      ret->append(entry);
-    }
-  else
-    for (auto it : *spectrum_data)
-    {
-      Entry entry({it.first[1]}, it.second);
-      ret->append(entry);
-    }
+  DataColumns columns;
+  source->data_columns(bounds, columns);
+  uint16_t dim = det1 ? 0 : 1;
+  Entry entry({0}, 0);
+  for (size_t i = 0; i < columns.size(); ++i)
+  {
+    entry.first[0] = columns.coord(i, dim);
+    entry.second = columns.counts[i];
+    ret->append(entry);
+  }
 
   ret->flush();
 
@@ -215,14 +212,15 @@ SinkPtr make_symmetrized(SinkPtr source)
   boost::random::mt19937 gen;
   boost::random::uniform_real_distribution<> dist(-0.5, 0.5);
 
-  std::unique_ptr<std::list<Entry>> spectrum_data = std::move(source->data_range({{0, adjrange}, {0, adjrange}}));
-  for (auto it : *spectrum_data)
+  DataColumns columns;
+  source->data_columns({{0, adjrange}, {0, adjrange}}, columns);
+  for (size_t n = 0; n < columns.size(); ++n)
   {
-    size_t e1 = it.first[0];
+    size_t e1 = columns.coord(n, 0);
 
-    double xformed = gain_match_cali.transform(it.first[1]);
+    double xformed = gain_match_cali.transform(columns.coord(n, 1));
 
-    for (int i=0; i < it.second; ++i)
+    for (int i=0; i < columns.counts[n]; ++i)
     {
       size_t e2 = std::max(static_cast<size_t>(0),
                            static_cast<size_t>(std::round(xformed + dist(gen))));
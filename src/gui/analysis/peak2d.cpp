@@ -142,10 +142,10 @@ void Bounds2D::integrate(Qpx::SinkPtr spectrum)
   if (md.dimensions() != 2)
     return;
 
-  std::shared_ptr<Qpx::EntryList> spectrum_data
-      = std::move(spectrum->data_range({{x.lower(), x.upper()}, {y.lower(), y.upper()}}));
-  for (auto &entry : *spectrum_data)
-    integral += to_double( entry.second );
+  Qpx::DataColumns columns;
+  spectrum->data_columns({{x.lower(), x.upper()}, {y.lower(), y.upper()}}, columns);
+  for (auto &count : columns.counts)
+    integral += to_double( count );
 
   variance = integral / pow(chan_area(), 2);
 }
@@ -253,7 +253,7 @@ void FormListDaq::displayStats(int idx)
   std::string info = stats.model_hit.to_string();
 
   i = 0;
-  for (auto &q : stats.items)
+  for (auto q : stats.items)
   {
     info += "\n" + q.first + " = " + to_string( q.second );
     i++;
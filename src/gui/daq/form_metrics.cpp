@@ -0,0 +1,86 @@
+/*******************************************************************************
+ *
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ *
+ * This software can be redistributed and/or modified freely provided that
+ * any derivative works bear some notice that they are derived from it, and
+ * any modified versions bear some notice that they have been modified.
+ *
+ * Author(s):
+ *      Martin Shetty (NIST)
+ *
+ * Description:
+ *      FormMetrics - live table of per-stage pipeline metrics
+ *
+ ******************************************************************************/
+
+#include "form_metrics.h"
+#include <QVBoxLayout>
+#include <QHeaderView>
+
+FormMetrics::FormMetrics(QWidget *parent)
+  : QWidget(parent)
+{
+  this->setWindowTitle("Pipeline");
+
+  label_elapsed_ = new QLabel(this);
+
+  table_ = new QTableWidget(this);
+  table_->setColumnCount(11);
+  table_->setHorizontalHeaderLabels({"stage", "calls", "items", "items/s", "busy s",
+                                     "mean us", "p50 us", "p90 us", "p99 us",
+                                     "max us", "depth (max)"});
+  table_->verticalHeader()->hide();
+  table_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  table_->setSelectionMode(QAbstractItemView::NoSelection);
+  table_->horizontalHeader()->setStretchLastSection(true);
+
+  QVBoxLayout *layout = new QVBoxLayout(this);
+  layout->addWidget(label_elapsed_);
+  layout->addWidget(table_);
+  setLayout(layout);
+
+  connect(&timer_, SIGNAL(timeout()), this, SLOT(refresh()));
+  timer_.start(1000);
+  refresh();
+}
+
+void FormMetrics::refresh()
+{
+  Qpx::MetricsSnapshot snap = Qpx::Engine::getInstance().metrics();
+
+  label_elapsed_->setText("Since run start: " + QString::number(snap.elapsed_s, 'f', 1) + " s");
+
+  table_->setRowCount(snap.stages.size());
+  for (size_t i = 0; i < snap.stages.size(); ++i)
+  {
+    const Qpx::StageSnapshot &s = snap.stages.at(i);
+    QStringList row {
+      QString::fromStdString(s.name),
+      QString::number(s.calls),
+      QString::number(s.items),
+      QString::number(s.items_per_s, 'f', 1),
+      QString::number(s.busy_s, 'f', 3),
+      QString::number(s.mean_us, 'f', 1),
+      QString::number(s.p50_us, 'f', 1),
+      QString::number(s.p90_us, 'f', 1),
+      QString::number(s.p99_us, 'f', 1),
+      QString::number(s.max_us, 'f', 1),
+      QString::number(s.depth) + " (" + QString::number(s.max_depth) + ")"
+    };
+    for (int j = 0; j < row.size(); ++j)
+    {
+      QTableWidgetItem *item = new QTableWidgetItem(row.at(j));
+      if (j > 0)
+        item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+      table_->setItem(i, j, item);
+    }
+  }
+  table_->resizeColumnsToContents();
+}
@@ -206,14 +206,16 @@ void FormPlot1D::update_plot()
 
     QVector<double> x = QVector<double>::fromStdVector(q.second->axis_values(0));
 
-    std::shared_ptr<EntryList> spectrum_data =
-        std::move(q.second->data_range({{0, x.size()}}));
+    q.second->data_columns({{0, x.size()}}, columns_);
 
     QPlot::HistMap1D hist;
-    for (auto it : *spectrum_data)
+    for (size_t i = 0; i < columns_.size(); ++i)
     {
-      double xx = x[it.first[0]];
-      double yy = to_double( it.second ) * rescale;
+      size_t chan = columns_.coord(i, 0);
+      if (chan >= static_cast<size_t>(x.size()))
+        break;
+      double xx = x[chan];
+      double yy = to_double( columns_.counts[i] ) * rescale;
       if (ui->pushPerLive->isChecked() && (livetime > 0))
         yy = yy / livetime;
       hist[xx] = yy;
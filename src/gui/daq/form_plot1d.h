@@ -111,4 +111,7 @@ private:
 
   bool nonempty_{false};
 
+  //reused across replots
+  Qpx::DataColumns columns_;
+
 };
@@ -264,15 +264,12 @@ void FormPlot2D::update_plot(bool force)
 
       ui->pushSymmetrize->setEnabled(sym.value_int == 0);
 
-      std::shared_ptr<EntryList> spectrum_data =
-          std::move(some_spectrum->data_range({{0, adjrange}, {0, adjrange}}));
+      some_spectrum->data_columns({{0, adjrange}, {0, adjrange}}, columns_);
 
       QPlot::HistList2D hist;
-      if (spectrum_data)
-      {
-        for (const auto& p : *spectrum_data)
-          hist.push_back(QPlot::p2d(p.first.at(0), p.first.at(1), to_double(p.second)));
-      }
+      for (size_t i = 0; i < columns_.size(); ++i)
+        hist.push_back(QPlot::p2d(columns_.coord(i, 0), columns_.coord(i, 1),
+                                  to_double(columns_.counts[i])));
 
       ui->coincPlot->clearData();
 
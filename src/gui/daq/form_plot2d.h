@@ -113,6 +113,9 @@ private:
   int bits;
   Qpx::Calibration calib_x_, calib_y_;
 
+  //reused across replots
+  Qpx::DataColumns columns_;
+
   QMenu *crop_menu_;
   QLabel *crop_label_;
   QSlider *crop_slider_;
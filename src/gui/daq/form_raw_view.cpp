@@ -240,7 +240,7 @@ void FormRawView::displayStats(int idx)
   std::string info = stats.model_hit.to_string();
 
   i = 0;
-  for (auto &q : stats.items)
+  for (auto q : stats.items)
   {
     info += "\n" + q.first + " = " + to_string( q.second );
     i++;
@@ -283,7 +283,7 @@ void FormRawView::spillSelectionChanged(int row)
     {
       if (i >= static_cast<int>(spills_.size()))
         continue;
-      Qpx::Spill& sp = spills_.at(i);
+      Qpx::Spill& sp = spills_.at(i).spill;
       if (sp.detectors.size())
         for (size_t di = 0; di < sp.detectors.size(); di++)
         {
@@ -300,14 +300,15 @@ void FormRawView::spillSelectionChanged(int row)
 
 
 
-    Qpx::Spill& sp = spills_.at(row);
-    if (hit_counts_.at(row) > 0)
+    Qpx::Spill& sp = spills_.at(row).spill;
+    if (spills_.at(row).hit_count > 0)
     {
-      file_bin_.seekg(bin_offsets_.at(row), std::ios::beg);
-      for (size_t i = 0; i < hit_counts_.at(row); ++i)
+      file_bin_.seekg(spills_.at(row).offset, std::ios::beg);
+      Qpx::TraceArenaPtr traces = std::make_shared<Qpx::TraceArena>();
+      for (size_t i = 0; i < spills_.at(row).hit_count; ++i)
       {
         Qpx::Hit one_hit;
-        one_hit.read_bin(file_bin_, hitmodels_);
+        one_hit.read_bin(file_bin_, hitmodels_, traces);
         hits_.push_back(one_hit);
       }
     }
@@ -400,7 +401,7 @@ void FormRawView::stats_selection_changed(QItemSelection, QItemSelection) {
 
 void FormRawView::on_pushLoadExperiment_clicked()
 {
-  QString fileName = QFileDialog::getOpenFileName(this, "Load raw", data_directory_, "qpx raw data (*.xml)");
+  QString fileName = QFileDialog::getOpenFileName(this, "Load raw", data_directory_, "qpx raw data (*.idx *.xml)");
   if (!validateFile(this, fileName, false))
     return;
 
@@ -417,53 +418,26 @@ void FormRawView::on_pushLoadExperiment_clicked()
   data_directory_ = path_of_file(fileName);
 
   spills_.clear();
-  hit_counts_.clear();
-  bin_offsets_.clear();
+  file_bin_.close();
   ui->listSpills->clear();
   spillSelectionChanged(-1);
 
-  pugi::xml_document doc;
-
-  if (!doc.load_file(fileName.toStdString().c_str())) {
-    WARN << "<ParserRaw> Could not parse XML in " << fileName.toStdString();
-    return;
-  }
-
-  pugi::xml_node root = doc.first_child();
-  if (!root || (std::string(root.name()) != "QpxListData")) {
-    WARN << "<ParserRaw> Bad root ID in " << fileName.toStdString();
-    this->setCursor(Qt::ArrowCursor);
-    return;
-  }
-
-  boost::filesystem::path meta(fileName.toStdString());
-  meta.make_preferred();
-  boost::filesystem::path path = meta.remove_filename();
-
-  if (!boost::filesystem::is_directory(meta)) {
-    DBG << "<ParserRaw> Bad path for list mode data";
+  Qpx::ListIndex index;
+  if (!index.load(fileName.toStdString())) {
     this->setCursor(Qt::ArrowCursor);
     return;
   }
 
-  boost::filesystem::path bin_path = path / "qpx_out.bin";
+  file_bin_.open(index.bin_path, std::ofstream::in | std::ofstream::binary);
 
-  file_bin_.open(bin_path.string(), std::ofstream::in | std::ofstream::binary);
-
-  if (!file_bin_.is_open()) {
-    DBG << "<ParserRaw> Could not open binary " << bin_path.string();
-    this->setCursor(Qt::ArrowCursor);
-    return;
-  }
-
-  if (!file_bin_.good()) {
+  if (!file_bin_.is_open() || !file_bin_.good()) {
     file_bin_.close();
-    DBG << "<ParserRaw> Could not open binary " << bin_path.string();
+    DBG << "<FormRawView> Could not open binary " << index.bin_path;
     this->setCursor(Qt::ArrowCursor);
     return;
   }
 
-  DBG << "<ParserRaw> Success opening binary " << bin_path.string();
+  DBG << "<FormRawView> Success opening binary " << index.bin_path;
 
   file_bin_.seekg (0, std::ios::beg);
   bin_begin_ = file_bin_.tellg();
@@ -471,27 +445,13 @@ void FormRawView::on_pushLoadExperiment_clicked()
   bin_end_ = file_bin_.tellg();
   file_bin_.seekg (0, std::ios::beg);
 
-  for (pugi::xml_node child : root.children()) {
-    std::string name = std::string(child.name());
-    if (name == Qpx::Spill().xml_element_name()) {
-      Qpx::Spill spill;
-      spill.from_xml(child);
-      if (spill != Qpx::Spill()) {
-        spills_.push_back(spill);
-        hit_counts_.push_back(child.attribute("raw_hit_count").as_ullong(0));
-        bin_offsets_.push_back(child.attribute("file_offset").as_ullong(0));
-
-        std::string text = spill.to_string();
-        if (hit_counts_.back() > 0)
-          text += "  [" + std::to_string(hit_counts_.back()) + "]";
-
-        ui->listSpills->addItem(QString::fromStdString(text));
-      }
-    }
+  spills_ = index.spills;
+  for (auto &ls : spills_) {
+    std::string text = ls.spill.to_string();
+    if (ls.hit_count > 0)
+      text += "  [" + std::to_string(ls.hit_count) + "]";
+    ui->listSpills->addItem(QString::fromStdString(text));
   }
 
-  if (spills_.size() == 0)
-    file_bin_.close();
-
   this->setCursor(Qt::ArrowCursor);
 }
@@ -24,6 +24,7 @@
 
 #include <QWidget>
 #include "spill.h"
+#include "list_index.h"
 #include "engine.h"
 #include "special_delegate.h"
 #include "widget_detectors.h"
@@ -65,9 +66,7 @@ private:
   QString data_directory_;    //data directory
 
 
-  std::vector<Qpx::Spill> spills_;
-  std::vector<size_t>     hit_counts_;
-  std::vector<uint64_t>   bin_offsets_;
+  std::vector<Qpx::ListSpill> spills_;
   std::ifstream  file_bin_;
   std::streampos bin_begin_, bin_end_;
 
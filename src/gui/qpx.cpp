@@ -39,6 +39,7 @@
 #include "form_gain_match.h"
 #include "form_experiment.h"
 #include "form_raw_view.h"
+#include "form_metrics.h"
 
 #include "qt_util.h"
 
@@ -99,6 +100,8 @@ qpx::qpx(QWidget *parent) :
   menuOpen.addSeparator();
   menuOpen.addAction(QIcon(":/icons/oxy/16/filenew.png"), "Live list mode", this, SLOT(open_list()));
   menuOpen.addAction(QIcon(":/icons/oxy/16/filenew.png"), "Live gain matching", this, SLOT(open_gain_matching()));
+  menuOpen.addSeparator();
+  menuOpen.addAction(QIcon(":/icons/oxy/16/filenew.png"), "Pipeline metrics", this, SLOT(open_metrics()));
   tb->setMenu(&menuOpen);
 
 
@@ -391,6 +394,14 @@ void qpx::open_raw()
   emit toggle_push(gui_enabled_, px_status_);
 }
 
+void qpx::open_metrics()
+{
+  FormMetrics *newMetricsForm = new FormMetrics(this);
+  addClosableTab(newMetricsForm, "Close");
+  ui->qpxTabs->setCurrentWidget(newMetricsForm);
+  reorder_tabs();
+}
+
 void qpx::open_experiment()
 {
   FormExperiment *experiment = new FormExperiment(runner_thread_, this);
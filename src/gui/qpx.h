@@ -124,6 +124,7 @@ private slots:
   void open_experiment();
   void open_list();
   void open_raw();
+  void open_metrics();
 
   void tabs_moved(int, int);
   void addClosableTab(QWidget*, QString);
@@ -283,13 +283,13 @@ void ThreadRunner::run()
       action_ = kNone;
       emit settingsUpdated(engine_.pull_settings(), engine_.get_detectors(), engine_.status());
     } else if (action_ == kPushSettings) {
-      engine_.push_settings(tree_);
-      engine_.get_all_settings();
+      if (!engine_.push_settings(tree_))
+        engine_.get_all_settings();
       action_ = kNone;
       emit settingsUpdated(engine_.pull_settings(), engine_.get_detectors(), engine_.status());
     } else if (action_ == kSetSetting) {
-      engine_.set_setting(tree_, match_conditions_);
-      engine_.get_all_settings();
+      if (!engine_.set_setting(tree_, match_conditions_))
+        engine_.get_all_settings();
       action_ = kNone;
       emit settingsUpdated(engine_.pull_settings(), engine_.get_detectors(), engine_.status());
     } else if (action_ == kSetDetector) {
@@ -56,7 +56,7 @@ QpxVmePlugin::~QpxVmePlugin() {
   die();
 }
 
-bool QpxVmePlugin::daq_start(SynchronizedQueue<Spill*>* out_queue) {
+bool QpxVmePlugin::daq_start(SpillQueue out_queue) {
   if (run_status_.load() > 0)
     return false;
 
@@ -70,7 +70,7 @@ bool QpxVmePlugin::daq_start(SynchronizedQueue<Spill*>* out_queue) {
     return false;
 
   run_status_.store(1);
-  raw_queue_ = new SynchronizedQueue<Spill*>();
+  raw_queue_ = new BoundedSpillQueue();
   //runner_ = new boost::thread(&worker_run_dbl, this, raw_queue_);
   //parser_ = new boost::thread(&worker_parse, this, raw_queue_, out_queue);
 
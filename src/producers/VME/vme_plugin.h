@@ -48,7 +48,7 @@ public:
 
 
   bool daq_init();
-  bool daq_start(SynchronizedQueue<Spill*>* out_queue);
+  bool daq_start(SpillQueue out_queue);
   bool daq_stop();
   bool daq_running();
 
@@ -73,7 +73,7 @@ protected:
   boost::atomic<int> run_status_;
   boost::thread *runner_;
   boost::thread *parser_;
-  SynchronizedQueue<Spill*>* raw_queue_;
+  SpillQueue raw_queue_;
 
 };
 
@@ -85,7 +85,7 @@ ParserEVT::~ParserEVT() {
   die();
 }
 
-bool ParserEVT::daq_start(SynchronizedQueue<Spill*>* out_queue) {
+bool ParserEVT::daq_start(SpillQueue out_queue) {
   if (run_status_.load() > 0)
     return false;
 
@@ -320,7 +320,7 @@ void ParserEVT::get_all_settings() {
 }
 
 
-void ParserEVT::worker_run(ParserEVT* callback, SynchronizedQueue<Spill*>* spill_queue) {
+void ParserEVT::worker_run(ParserEVT* callback, SpillQueue spill_queue) {
   DBG << "<ParserEVT> Start run worker";
 
   Spill one_spill;
@@ -516,7 +516,8 @@ void ParserEVT::worker_run(ParserEVT* callback, SynchronizedQueue<Spill*>* spill
 
 
 
-              one_spill.hits.splice(one_spill.hits.end(), hits);
+              for (auto &h : hits)
+                one_spill.hits.push_back(h);
 
               prev_MADC_data = MADC_data;
               prev_pattern = madc_pattern;
@@ -569,10 +570,10 @@ void ParserEVT::worker_run(ParserEVT* callback, SynchronizedQueue<Spill*>* spill
 //      DBG << "about to enqueue spill with hits " << one_spill.hits.size() << " ts= " << boost::posix_time::to_iso_extended_string(ts)
 //             << " and stats updates " << one_spill.stats.size();
       if (!extra_spill.stats.empty())
-        spill_queue->enqueue(new Spill(extra_spill));
+        spill_queue->enqueue(std::unique_ptr<Spill>(new Spill(extra_spill)));
       extra_spill = Spill();
 
-      spill_queue->enqueue(new Spill(one_spill));
+      spill_queue->enqueue(std::unique_ptr<Spill>(new Spill(one_spill)));
 
       timeout = (callback->run_status_.load() == 2)
           || (callback->terminate_premature_ && (count >= callback->max_rbuf_evts_))
@@ -598,7 +599,7 @@ void ParserEVT::worker_run(ParserEVT* callback, SynchronizedQueue<Spill*>* spill
       one_spill.stats[q] = udt;
       //    DBG << "Sending stop at ts= " << boost::posix_time::to_iso_extended_string(ts) << " with evts " << one_spill.hits.size();
     }
-    spill_queue->enqueue(new Spill(one_spill));
+    spill_queue->enqueue(std::unique_ptr<Spill>(new Spill(one_spill)));
   }
 
   callback->run_status_.store(3);
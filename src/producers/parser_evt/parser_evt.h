@@ -49,7 +49,7 @@ public:
   bool boot() override;
   bool die() override;
 
-  bool daq_start(SynchronizedQueue<Spill*>* out_queue) override;
+  bool daq_start(SpillQueue out_queue) override;
   bool daq_stop() override;
   bool daq_running() override;
 
@@ -59,7 +59,7 @@ private:
   ParserEVT(const ParserEVT&);
 
   //Acquisition threads, use as static functors
-  static void worker_run(ParserEVT* callback, SynchronizedQueue<Spill*>* spill_queue);
+  static void worker_run(ParserEVT* callback, SpillQueue spill_queue);
 
 protected:
 
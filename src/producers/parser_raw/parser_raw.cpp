@@ -24,8 +24,10 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string.hpp>
+#include <chrono>
 #include "custom_logger.h"
 #include "custom_timer.h"
+#include "pipeline_metrics.h"
 #include "producer_factory.h"
 
 
@@ -42,17 +44,17 @@ ParserRaw::ParserRaw() {
 
   loop_data_ = false;
   override_timestamps_= false;
+  max_speed_ = false;
+  total_hits_ = 0;
 }
 
 bool ParserRaw::die() {
-  if ((status_ & ProducerStatus::booted) != 0)
-    file_bin_.close();
+  file_bin_.reset();
 
   source_file_bin_.clear();
 
   spills_.clear();
-  bin_begin_ = 0;
-  bin_end_ = 0;
+  total_hits_ = 0;
 
   status_ = ProducerStatus::loaded | ProducerStatus::can_boot;
 //  for (auto &q : set.branches.my_data_) {
@@ -73,7 +75,7 @@ ParserRaw::~ParserRaw() {
   die();
 }
 
-bool ParserRaw::daq_start(SynchronizedQueue<Spill*>* out_queue) {
+bool ParserRaw::daq_start(SpillQueue out_queue) {
   if (run_status_.load() > 0)
     return false;
 
@@ -123,6 +125,8 @@ void ParserRaw::read_settings_bulk(Qpx::Setting &set) const
         q.value_int = loop_data_;
       else if ((q.metadata.setting_type == Qpx::SettingType::boolean) && (q.id_ == "ParserRaw/Override pause"))
         q.value_int = override_pause_;
+      else if ((q.metadata.setting_type == Qpx::SettingType::boolean) && (q.id_ == "ParserRaw/Max speed"))
+        q.value_int = max_speed_;
       else if ((q.metadata.setting_type == Qpx::SettingType::integer) && (q.id_ == "ParserRaw/Pause"))
         q.value_int = pause_ms_;
       else if ((q.metadata.setting_type == Qpx::SettingType::file_path) && (q.id_ == "ParserRaw/Producer file")) {
@@ -134,14 +138,14 @@ void ParserRaw::read_settings_bulk(Qpx::Setting &set) const
       else if ((q.metadata.setting_type == Qpx::SettingType::integer) && (q.id_ == "ParserRaw/Spills"))
         q.value_int = spills_.size();
       else if ((q.metadata.setting_type == Qpx::SettingType::integer) && (q.id_ == "ParserRaw/Hits"))
-        q.value_int = (bin_end_ - bin_begin_) / 12;
+        q.value_int = total_hits_;
       else if ((q.metadata.setting_type == Qpx::SettingType::time) && (q.id_ == "ParserRaw/StartTime")) {
         if (!spills_.empty())
-          q.value_time = spills_.front().time;
+          q.value_time = spills_.front().spill.time;
       }
       else if ((q.metadata.setting_type == Qpx::SettingType::time_duration) && (q.id_ == "ParserRaw/RunDuration")) {
         if (!spills_.empty())
-          q.value_duration = spills_.back().time - spills_.front().time;
+          q.value_duration = spills_.back().spill.time - spills_.front().spill.time;
       }
     }
   }
@@ -163,6 +167,8 @@ void ParserRaw::write_settings_bulk(Qpx::Setting &set)
       loop_data_ = q.value_int;
     else if (q.id_ == "ParserRaw/Override pause")
       override_pause_ = q.value_int;
+    else if (q.id_ == "ParserRaw/Max speed")
+      max_speed_ = q.value_int;
     else if (q.id_ == "ParserRaw/Pause")
       pause_ms_ = q.value_int;
     else if (q.id_ == "ParserRaw/Producer file")
@@ -178,75 +184,26 @@ bool ParserRaw::boot() {
 
   status_ = ProducerStatus::loaded | ProducerStatus::can_boot;
 
-  pugi::xml_document doc;
-
-  if (!doc.load_file(source_file_.c_str())) {
-    WARN << "<ParserRaw> Could not parse XML in " << source_file_;
-    return false;
-  }
-
-  pugi::xml_node root = doc.first_child();
-  if (!root || (std::string(root.name()) != "QpxListData")) {
-    WARN << "<ParserRaw> Bad root ID in " << source_file_;
+  ListIndex index;
+  if (!index.load(source_file_))
     return false;
-  }
-
-  boost::filesystem::path meta(source_file_);
-  meta.make_preferred();
-  boost::filesystem::path path = meta.remove_filename();
 
-  if (!boost::filesystem::is_directory(meta)) {
-    DBG << "<ParserRaw> Bad path for list mode data";
+  file_bin_ = std::make_shared<MappedFile>();
+  if (!file_bin_->open(index.bin_path)) {
+    file_bin_.reset();
     return false;
   }
 
-  boost::filesystem::path bin_path = path / "qpx_out.bin";
+  DBG << "<ParserRaw> Mapped binary " << index.bin_path
+      << " (" << file_bin_->size() << " bytes)";
 
-  file_bin_.open(bin_path.string(), std::ofstream::in | std::ofstream::binary);
-
-  if (!file_bin_.is_open()) {
-    DBG << "<ParserRaw> Could not open binary " << bin_path.string();
-    return false;
-  }
-
-  if (!file_bin_.good()) {
-    file_bin_.close();
-    DBG << "<ParserRaw> Could not open binary " << bin_path.string();
-    return false;
-  }
-
-  DBG << "<ParserRaw> Success opening binary " << bin_path.string();
-
-  file_bin_.seekg (0, std::ios::beg);
-  bin_begin_ = file_bin_.tellg();
-  file_bin_.seekg (0, std::ios::end);
-  bin_end_ = file_bin_.tellg();
-  file_bin_.seekg (0, std::ios::beg);
-
-  for (pugi::xml_node child : root.children()) {
-    std::string name = std::string(child.name());
-    if (name == Qpx::Spill().xml_element_name()) {
-      Qpx::Spill spill;
-      spill.from_xml(child);
-      if (spill != Qpx::Spill()) {
-        spills_.push_back(spill);
-        hit_counts_.push_back(child.attribute("raw_hit_count").as_ullong(0));
-        bin_offsets_.push_back(child.attribute("file_offset").as_ullong(0));
-
-        std::string text = spill.to_string();
-        if (hit_counts_.back() > 0)
-          text += "  [" + std::to_string(hit_counts_.back()) + "]";
-      }
-    }
-  }
-
-  if (spills_.size() == 0) {
-    file_bin_.close();
-    return false;
-  }
+  spills_ = index.spills;
+  source_file_bin_ = index.bin_path;
+  total_hits_ = 0;
+  for (auto &ls : spills_)
+    total_hits_ += ls.hit_count;
 
   current_spill_ = 0;
-  source_file_bin_ = bin_path.string();
   status_ = ProducerStatus::loaded | ProducerStatus::booted | ProducerStatus::can_run;
   return true;
 }
@@ -258,17 +215,25 @@ void ParserRaw::get_all_settings() {
 }
 
 
-void ParserRaw::worker_run(ParserRaw* callback, SynchronizedQueue<Spill*>* spill_queue) {
+void ParserRaw::worker_run(ParserRaw* callback, SpillQueue spill_queue) {
   DBG << "<ParserRaw> Start run worker";
 
-  Spill one_spill, prevspill;
+  Spill one_spill, last_spill;
+  boost::posix_time::ptime prev_time;
 
   bool timeout = false;
+  StageMetrics* read_stage = PipelineMetrics::get().stage(Stage::read);
+
+  uint64_t hits_replayed = 0;
+  auto replay_start = std::chrono::steady_clock::now();
 
   while ((callback->current_spill_ < callback->spills_.size()) && (!timeout)) {
 
-    prevspill = one_spill;
+    StageTimer read_timer(read_stage);
     one_spill = callback->get_spill();
+    read_timer.items(one_spill.hits.size());
+    read_timer.stop();
+    hits_replayed += one_spill.hits.size();
 
     if (callback->override_timestamps_) {
       one_spill.time = boost::posix_time::microsec_clock::universal_time();
@@ -277,17 +242,18 @@ void ParserRaw::worker_run(ParserRaw* callback, SynchronizedQueue<Spill*>* spill
       // livetime and realtime are not changed accordingly
     }
 
-    if (callback->override_pause_) {
+    if (callback->max_speed_) {
+      //no pause at all
+    } else if (callback->override_pause_) {
       boost::this_thread::sleep(boost::posix_time::milliseconds(callback->pause_ms_));
     } else {
-      if ((one_spill != Spill()) && (prevspill != Spill())) {
-        if (one_spill.time > prevspill.time) {
-          boost::posix_time::time_duration dif = one_spill.time - prevspill.time;
-          //        DBG << "<ParserRaw> Pause for " << dif.total_seconds();
-          boost::this_thread::sleep(dif);
-        }
+      if (!prev_time.is_not_a_date_time() && (one_spill.time > prev_time)) {
+        boost::posix_time::time_duration dif = one_spill.time - prev_time;
+        //        DBG << "<ParserRaw> Pause for " << dif.total_seconds();
+        boost::this_thread::sleep(dif);
       }
     }
+    prev_time = one_spill.time;
 
 //    for (auto &q : one_spill.stats) {
 //      if (!starts_signalled.count(q.source_channel)) {
@@ -295,21 +261,32 @@ void ParserRaw::worker_run(ParserRaw* callback, SynchronizedQueue<Spill*>* spill
 //        starts_signalled.insert(q.source_channel);
 //      }
 //    }
-    spill_queue->enqueue(new Spill(one_spill));
+
+    //all but the hits, for the closing spill
+    last_spill.time = one_spill.time;
+    last_spill.stats = one_spill.stats;
+    last_spill.state = one_spill.state;
+    last_spill.detectors = one_spill.detectors;
+
+    spill_queue->enqueue(std::unique_ptr<Spill>(new Spill(std::move(one_spill))));
 
     timeout = (callback->run_status_.load() == 2);
   }
 
-  for (auto &q : one_spill.stats)
+  double replay_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - replay_start).count();
+
+  for (auto &q : last_spill.stats)
     q.second.stats_type = StatsUpdate::Type::stop;
-  one_spill.hits.clear();
 
-  spill_queue->enqueue(new Spill(one_spill));
+  spill_queue->enqueue(std::unique_ptr<Spill>(new Spill(last_spill)));
 
   if (callback->spills_.empty()) {
     DBG << "<ParserRaw> Out of spills. Premature termination";
   }
 
+  LINFO << "<ParserRaw> Replayed " << hits_replayed << " hits in " << replay_s << " s ("
+        << ((replay_s > 0) ? (hits_replayed / replay_s) : 0) << " hits/s)";
+
   callback->run_status_.store(3);
 
   DBG << "<ParserRaw> Stop run worker";
@@ -324,17 +301,37 @@ Spill ParserRaw::get_spill() {
   if (spills_.empty() || (current_spill_ >= spills_.size()))
     return one_spill;
 
-  one_spill = spills_.at(current_spill_);
+  const ListSpill& ls = spills_.at(current_spill_);
+  one_spill = ls.spill;
 
   //      DBG << "<Sorter> will produce no of events " << spills_.front().events_in_spill;
-  if (hit_counts_.at(current_spill_) > 0)
+  if ((ls.hit_count > 0) && (ls.offset < file_bin_->size()))
   {
-    file_bin_.seekg(bin_offsets_.at(current_spill_), std::ios::beg);
-    for (size_t i = 0; i < hit_counts_.at(current_spill_); ++i)
+    const char* in  = file_bin_->data() + ls.offset;
+    const char* end = file_bin_->data() + file_bin_->size();
+
+    //traces stay in the mapping, which the arena keeps alive
+    TraceArenaPtr traces = std::make_shared<TraceArena>();
+    traces->hold(file_bin_);
+
+    one_spill.hits.reserve(ls.hit_count);
+    Qpx::Hit one_hit;
+    for (size_t i = 0; i < ls.hit_count; ++i)
     {
-      Qpx::Hit one_hit;
-      one_hit.read_bin(file_bin_, hitmodels_);
+      const char* next = one_hit.read_bin(in, end, hitmodels_, traces);
+      if (!next) {
+        WARN << "<ParserRaw> Could not decode hit " << i << " of " << ls.hit_count
+             << " in spill " << current_spill_ << " at offset " << (in - file_bin_->data());
+        break;
+      }
       one_spill.hits.push_back(one_hit);
+      in = next;
+    }
+
+    //start reading the next spill while this one is processed
+    if ((current_spill_ + 1) < spills_.size()) {
+      const ListSpill& nxt = spills_.at(current_spill_ + 1);
+      file_bin_->will_need(nxt.offset, nxt.bytes ? nxt.bytes : (in - file_bin_->data() - ls.offset));
     }
   }
 
@@ -24,6 +24,8 @@
 
 #include "producer.h"
 #include "detector.h"
+#include "list_index.h"
+#include "mapped_file.h"
 #include <boost/thread.hpp>
 #include <boost/atomic.hpp>
 
@@ -46,7 +48,7 @@ public:
   bool boot() override;
   bool die() override;
 
-  bool daq_start(SynchronizedQueue<Spill*>* out_queue) override;
+  bool daq_start(SpillQueue out_queue) override;
   bool daq_stop() override;
   bool daq_running() override;
 
@@ -56,7 +58,7 @@ private:
   ParserRaw(const ParserRaw&);
 
   //Acquisition threads, use as static functors
-  static void worker_run(ParserRaw* callback, SynchronizedQueue<Spill*>* spill_queue);
+  static void worker_run(ParserRaw* callback, SpillQueue spill_queue);
 
 protected:
   boost::atomic<int> run_status_;
@@ -68,18 +70,17 @@ protected:
   bool loop_data_;
   bool override_pause_;
   bool override_timestamps_;
+  bool max_speed_;
   int  pause_ms_;
   std::string source_file_;
   std::string source_file_bin_;
 
   size_t current_spill_;
-  std::vector<Spill> spills_;
-  std::vector<size_t>     hit_counts_;
-  std::vector<uint64_t>   bin_offsets_;
+  std::vector<ListSpill> spills_;
+  uint64_t               total_hits_;
   std::map<int16_t, Qpx::HitModel> hitmodels_;
 
-  std::ifstream  file_bin_;
-  std::streampos bin_begin_, bin_end_;
+  MappedFilePtr  file_bin_;
 
   Spill get_spill();
 
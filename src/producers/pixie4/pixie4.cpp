@@ -22,6 +22,7 @@
 #include <boost/filesystem.hpp>
 #include "custom_logger.h"
 #include "custom_timer.h"
+#include "pipeline_metrics.h"
 
 #define SLOT_WAVE_OFFSET      7
 #define NUMBER_OF_CHANNELS    4
@@ -89,7 +90,7 @@ bool Pixie4::daq_start(SpillQueue out_queue)
 
   PixieAPI.reset_counters_next_run(); //assume new run
 
-  raw_queue_ = new SynchronizedQueue<Spill*>();
+  raw_queue_ = new BoundedSpillQueue();
 
   if (parser_ != nullptr)
     delete parser_;
@@ -128,6 +129,7 @@ bool Pixie4::daq_stop()
     delete parser_;
     parser_ = nullptr;
   }
+  DBG << "<Pixie4> Raw spill queue " << raw_queue_->stats().to_string();
   delete raw_queue_;
   raw_queue_ = nullptr;
 
@@ -164,17 +166,17 @@ HitModel Pixie4::model_hit(uint16_t runtype)
 void Pixie4::fill_stats(std::map<int16_t, StatsUpdate> &all_stats, uint8_t module)
 {
   StatsUpdate stats;
-  stats.items["native_time"] = PixieAPI.get_mod(module, "TOTAL_TIME");
+  stats.items[StatsKey::native_time] = PixieAPI.get_mod(module, "TOTAL_TIME");
   stats.model_hit = model_hit(run_setup.type);
   //tracelength?!?!?!
   for (uint16_t i=0; i < run_setup.indices[module].size(); ++i)
   {
     stats.source_channel         = run_setup.indices[module][i];
-    stats.items["trigger_count"] = PixieAPI.get_chan(module, i, "FAST_PEAKS");
+    stats.items[StatsKey::trigger_count] = PixieAPI.get_chan(module, i, "FAST_PEAKS");
     double live_time  = PixieAPI.get_chan(module, i, "LIVE_TIME");
-    stats.items["live_time"]    = live_time -
+    stats.items[StatsKey::live_time]    = live_time -
         PixieAPI.get_chan(module, i, "SFDT");
-    stats.items["live_trigger"] = live_time -
+    stats.items[StatsKey::live_trigger] = live_time -
         PixieAPI.get_chan(module, i, "FTDT");
     all_stats[stats.source_channel] = stats;
   }
@@ -499,6 +501,67 @@ void Pixie4::write_channel(Setting &set, uint16_t modnum)
   }
 }
 
+bool Pixie4::write_settings(Setting &set, const std::list<SettingPath> &changed)
+{
+  if (set.id_ != device_name())
+    return false;
+
+  for (auto &path : changed)
+    if (!write_one(path))
+      return false;
+  return true;
+}
+
+bool Pixie4::write_one(const SettingPath &path)
+{
+  //commands, files and system-wide parameters may restructure or
+  //invalidate everything; those go through the bulk path
+  Setting &k = *path.back();
+  if ((path.size() < 3) || (k.metadata.setting_type == SettingType::command))
+    return false;
+
+  if (path[1]->id_ == "Pixie4/Run settings")
+  {
+    write_run_settings(*path[1]);
+    read_run_settings(*path[1]);
+    return true;
+  }
+
+  if (path[1]->id_ != "Pixie4/System")
+    return false;
+
+  if (path.size() == 4)
+  {
+    Setting &module = *path[2];
+    int16_t modnum = module.metadata.address;
+    if ((module.metadata.setting_type != SettingType::stem) || !PixieAPI.module_valid(modnum))
+      return false;
+    if (k.metadata.writable && (PixieAPI.get_mod(modnum, k.metadata.address) != get_value(k)))
+      PixieAPI.set_mod(modnum, k.metadata.name, get_value(k));
+    //module parameters such as FILTER_RANGE change channel limits
+    read_module(module);
+    return true;
+  }
+
+  if (path.size() == 5)
+  {
+    Setting &channel = *path[3];
+    int16_t modnum = path[2]->metadata.address;
+    int16_t channum = channel.metadata.address;
+    if ((channel.metadata.setting_type != SettingType::stem) ||
+        !PixieAPI.module_valid(modnum) || !PixieAPI.channel_valid(channum))
+      return false;
+    if (k.metadata.writable &&
+        (PixieAPI.get_chan(modnum, channum, k.metadata.address) != get_value(k)))
+      PixieAPI.set_chan(modnum, channum, k.metadata.name, get_value(k));
+    //the API recomputes dependent channel parameters
+    read_channel(channel, modnum, PixieAPI.get_mod(modnum, "FILTER_RANGE"));
+    return true;
+  }
+
+  return false;
+}
+
 bool Pixie4::boot()
 {
   if (!(status_ & ProducerStatus::can_boot))
@@ -541,6 +604,7 @@ bool Pixie4::die()
 std::list<Hit> Pixie4::oscilloscope()
 {
   std::list<Hit> result;
+  TraceArenaPtr traces = std::make_shared<TraceArena>();
 
   uint32_t* oscil_data;
 
@@ -559,7 +623,7 @@ std::list<Hit> Pixie4::oscilloscope()
           hm.timebase = TimeStamp(PixieAPI.get_chan(m, i, "XDT") * 1000, 1); //us to ns
           hm.tracelength = Pixie4Wrapper::max_buf_len;
           Hit tr(run_setup.indices[m][i], hm);
-          tr.set_trace(trace);
+          tr.set_trace(trace.data(), trace.size(), traces);
           result.push_back(tr);
         }
       }
@@ -628,7 +692,9 @@ void Pixie4::worker_run_dbl(Pixie4* callback, SpillQueue spill_queue)
     q.second.lab_time = fetched_spill.time;
     q.second.stats_type = StatsUpdate::Type::start;
   }
-  spill_queue->enqueue(new Spill(fetched_spill));
+  spill_queue->enqueue(std::unique_ptr<Spill>(new Spill(fetched_spill)));
+
+  StageMetrics* read_stage = PipelineMetrics::get().stage(Stage::read);
 
   //Main data acquisition loop
   bool timeout = false;
@@ -665,8 +731,11 @@ void Pixie4::worker_run_dbl(Pixie4* callback, SpillQueue spill_queue)
     {
       fetched_spill = Spill();
       fetched_spill.data.resize(Pixie4Wrapper::list_mem_len32, 0);
+      StageTimer read_timer(read_stage);
+      read_timer.items(Pixie4Wrapper::list_mem_len32);
       if (pixie.read_EM_double_buffered(fetched_spill.data.data(), q))
         success = true;
+      read_timer.stop();
 
       callback->fill_stats(fetched_spill.stats, q);
       for (auto &p : fetched_spill.stats)
@@ -675,7 +744,7 @@ void Pixie4::worker_run_dbl(Pixie4* callback, SpillQueue spill_queue)
         if (timeout)
           p.second.stats_type = StatsUpdate::Type::stop;
       }
-      spill_queue->enqueue(new Spill(fetched_spill));
+      spill_queue->enqueue(std::unique_ptr<Spill>(new Spill(fetched_spill)));
     }
 
     if (!success)
@@ -692,7 +761,7 @@ void Pixie4::worker_run_dbl(Pixie4* callback, SpillQueue spill_queue)
     q.second.lab_time = fetched_spill.time;
     q.second.stats_type = StatsUpdate::Type::stop;
   }
-  spill_queue->enqueue(new Spill(fetched_spill));
+  spill_queue->enqueue(std::unique_ptr<Spill>(new Spill(fetched_spill)));
   callback->running_.store(false);
 }
 
@@ -702,19 +771,22 @@ void Pixie4::worker_parse (RunSetup setup,
                            SpillQueue in_queue,
                            SpillQueue out_queue)
 {
-  Spill* spill;
+  std::unique_ptr<Spill> spill;
   auto run_setup = setup;
 
   uint64_t all_hits = 0, cycles = 0;
   CustomTimer parse_timer;
+  StageMetrics* parse_stage = PipelineMetrics::get().stage(Stage::parse);
 
-  while ((spill = in_queue->dequeue()) != NULL)
+  while ((spill = in_queue->dequeue()) != nullptr)
   {
     parse_timer.resume();
+    StageTimer parse_pass(parse_stage);
 
     if (spill->data.size() > 0)
     {
       cycles++;
+      TraceArenaPtr traces = std::make_shared<TraceArena>();
       uint16_t* buff16 = (uint16_t*) spill->data.data();
       uint32_t idx = 0, spill_hits = 0;
 
@@ -774,7 +846,7 @@ void Pixie4::worker_parse (RunSetup setup,
               one_hit.set_value(3, buff16[idx++]); //user_PSA
               idx += 3;
               hi                  = buff16[idx++]; //not always?
-              one_hit.set_trace(std::vector<uint16_t>(buff16 + idx, buff16 + idx + trace_len));
+              one_hit.set_trace(buff16 + idx, trace_len, traces);
               idx += trace_len;
             }
             else if (task_b == 0x0001)
@@ -832,7 +904,9 @@ void Pixie4::worker_parse (RunSetup setup,
       all_hits += spill_hits;
     }
     spill->data.clear();
-    out_queue->enqueue(spill);
+    parse_pass.items(spill->hits.size());
+    parse_pass.stop();
+    out_queue->enqueue(std::move(spill));
     parse_timer.stop();
   }
 
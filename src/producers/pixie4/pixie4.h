@@ -39,6 +39,7 @@ public:
 
   void write_settings_bulk(Setting &set) override;
   void read_settings_bulk(Setting &set) const override;
+  bool write_settings(Setting &set, const std::list<SettingPath> &changed) override;
   void get_all_settings() override;
   bool boot() override;
   bool die() override;
@@ -92,6 +93,7 @@ protected:
   void write_system(Setting &set);
   void write_module(Setting &set);
   void write_channel(Setting &set, uint16_t modnum);
+  bool write_one(const SettingPath &path);
 
   void rebuild_structure(Setting &set);
   void reindex_modules(Setting &set);
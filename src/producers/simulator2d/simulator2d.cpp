@@ -26,6 +26,7 @@
 #include <boost/algorithm/string.hpp>
 #include "custom_logger.h"
 #include "custom_timer.h"
+#include "pipeline_metrics.h"
 
 #include "project.h"
 #include "producer_factory.h"
@@ -67,7 +68,7 @@ Simulator2D::~Simulator2D() {
   die();
 }
 
-bool Simulator2D::daq_start(SynchronizedQueue<Spill*>* out_queue) {
+bool Simulator2D::daq_start(SpillQueue out_queue) {
   if (run_status_.load() > 0)
     return false;
 
@@ -327,7 +328,7 @@ void Simulator2D::get_all_settings() {
 }
 
 
-void Simulator2D::worker_run(Simulator2D* callback, SynchronizedQueue<Spill*>* spill_queue) {
+void Simulator2D::worker_run(Simulator2D* callback, SpillQueue spill_queue) {
   bool timeout = false;
 
   double   rate0 = callback->OCR * callback->scale_rate_ * 0.01;
@@ -353,9 +354,10 @@ void Simulator2D::worker_run(Simulator2D* callback, SynchronizedQueue<Spill*>* s
   moving_stats.source_channel = callback->chan1_;
   one_spill.stats[callback->chan1_] = moving_stats;
 
-  spill_queue->enqueue(new Spill(one_spill));
+  spill_queue->enqueue(std::unique_ptr<Spill>(new Spill(one_spill)));
 
   CustomTimer timer(true);
+  StageMetrics* read_stage = PipelineMetrics::get().stage(Stage::read);
   while (!timeout)
   {
     uint64_t rate = rate0 * exp(0.0 - lambda * timer.s());
@@ -365,7 +367,10 @@ void Simulator2D::worker_run(Simulator2D* callback, SynchronizedQueue<Spill*>* s
         << "  current rate = " << rate;
 
     one_spill = Spill();
+    callback->traces_ = std::make_shared<TraceArena>();
 
+    //generation stands in for reading a device
+    StageTimer read_timer(read_stage);
     for (uint32_t i=0; i< (rate * callback->spill_interval_); i++) {
       if (callback->resolution_ > 0) {
         uint64_t newpoint = callback->dist_(callback->gen);
@@ -386,6 +391,8 @@ void Simulator2D::worker_run(Simulator2D* callback, SynchronizedQueue<Spill*>* s
         callback->push_hit(one_spill, en1, en2);
       }
     }
+    read_timer.items(one_spill.hits.size());
+    read_timer.stop();
 
     moving_stats = moving_stats + one_run;
     moving_stats.model_hit = callback->model_hit;
@@ -399,7 +406,7 @@ void Simulator2D::worker_run(Simulator2D* callback, SynchronizedQueue<Spill*>* s
     moving_stats.source_channel = callback->chan1_;
     one_spill.stats[callback->chan1_] = moving_stats;
 
-    spill_queue->enqueue(new Spill(one_spill));
+    spill_queue->enqueue(std::unique_ptr<Spill>(new Spill(one_spill)));
 
     timeout = (callback->run_status_.load() == 2);
   }
@@ -408,7 +415,7 @@ void Simulator2D::worker_run(Simulator2D* callback, SynchronizedQueue<Spill*>* s
   for (auto &q : one_spill.stats)
     q.second.stats_type = StatsUpdate::Type::stop;
 
-  spill_queue->enqueue(new Spill(one_spill));
+  spill_queue->enqueue(std::unique_ptr<Spill>(new Spill(one_spill)));
 
   callback->run_status_.store(3);
 
@@ -423,7 +430,7 @@ void Simulator2D::push_hit(Spill& one_spill, uint16_t en1, uint16_t en2)
     h.set_timestamp_native(clock_);
     h.set_value(0, round(en1 * gain0_ * 0.01));
     h.set_value(1, rand() % 100);
-    make_trace(h, 1000);
+    make_trace(h, 1000, traces_);
     one_spill.hits.push_back(h);
   }
 
@@ -433,17 +440,17 @@ void Simulator2D::push_hit(Spill& one_spill, uint16_t en1, uint16_t en2)
     h.set_timestamp_native(clock_);
     h.set_value(0, round(en2 * gain1_ * 0.01));
     h.set_value(1, rand() % 100);
-    make_trace(h, 1000);
+    make_trace(h, 1000, traces_);
     one_spill.hits.push_back(h);
   }
 
   clock_ += coinc_thresh_ + 1;
 }
 
-void Simulator2D::make_trace(Hit& h, uint16_t baseline)
+void Simulator2D::make_trace(Hit& h, uint16_t baseline, const TraceArenaPtr& arena)
 {
   uint16_t en = h.value(0).val(h.value(0).bits());
-  std::vector<uint16_t> trc(h.trace().size(), baseline);
+  std::vector<uint16_t> trc(h.trace_length(), baseline);
   size_t start = double(trc.size()) * 0.1;
   double slope1 = double(en) / double(start);
   double slope2 = - double(en) / double(trc.size() * 10);
@@ -453,7 +460,7 @@ void Simulator2D::make_trace(Hit& h, uint16_t baseline)
     trc[i] += en + (i - 2*start) * slope2;
   for (size_t i=0; i < trc.size(); ++i)
     trc[i] += (rand() % baseline) / 5 - baseline/10;
-  h.set_trace(trc);
+  h.set_trace(trc.data(), trc.size(), arena);
 }
 
 Spill Simulator2D::get_spill() {
@@ -468,7 +475,7 @@ StatsUpdate Simulator2D::getBlock(double duration)
 
   double fraction;
 
-  newBlock.items["native_time"] = duration;
+  newBlock.items[StatsKey::native_time] = duration;
 
   if (lab_time == 0.0)
     fraction = duration;
@@ -477,8 +484,8 @@ StatsUpdate Simulator2D::getBlock(double duration)
 
   if (std::isfinite(live_time) && (live_time > 0))
   {
-    newBlock.items["live_time"] = live_time;
-    newBlock.items["live_trigger"] = live_time;
+    newBlock.items[StatsKey::live_time] = live_time;
+    newBlock.items[StatsKey::live_trigger] = live_time;
   }
 
   return newBlock;
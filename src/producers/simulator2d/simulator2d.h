@@ -48,7 +48,7 @@ public:
   bool boot() override;
   bool die() override;
 
-  bool daq_start(SynchronizedQueue<Spill*>* out_queue) override;
+  bool daq_start(SpillQueue out_queue) override;
   bool daq_stop() override;
   bool daq_running() override;
 
@@ -58,7 +58,7 @@ private:
   Simulator2D(const Simulator2D&);
 
   //Acquisition threads, use as static functors
-  static void worker_run(Simulator2D* callback, SynchronizedQueue<Spill*>* spill_queue);
+  static void worker_run(Simulator2D* callback, SpillQueue spill_queue);
 
 protected:
 
@@ -103,8 +103,10 @@ protected:
 
   uint64_t clock_;
 
+  TraceArenaPtr traces_; //per spill
+
   void push_hit(Spill&, uint16_t, uint16_t);
-  static void make_trace(Hit& h, uint16_t baseline);
+  static void make_trace(Hit& h, uint16_t baseline, const TraceArenaPtr& arena);
 
 };
 